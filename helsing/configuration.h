@@ -71,6 +71,9 @@
  * 	3. By using 3 * 16-bits instead of 64-bits.
  * 	   That would result in 75% array size and 121% runtime*.
  *
+ * 	4. By storing a 16-bit index to the unique elements, see 'packed'.
+ * 	   That would result in 25% array size and 90% runtime* at 18 digits.
+ *
  * 	*Based on some of my testing in base-10. Your mileage may vary.
  *
  * CACHE Options:
@@ -87,9 +90,41 @@
  * 3) PDEP:
  * 	Use DEDICATED_BITFIELDS and half the CACHE size, then use pdep to expand
  * 	from 32 to 64 bits.
+ * 	On cpus without BMI2 the expansion is done in software.
  *
  * These options adjust the space of solvable intervals to avoid
- * false-positives.
+ * false-positives. The lengths of products outside of it are checked with
+ * the kernel 'nocache' instead, see kernel_band.
+ *
+ * Kernels:
+ * 	The loop that checks the multiplicands of each multiplier is picked at
+ * 	runtime, based on the instruction sets that the cpu supports (AVX-512,
+ * 	AVX2, BMI2 for PDEP). It can be overridden with --kernel=[name] and
+ * 	--buildconf shows which one is active. The kernel 'nocache' doesn't use
+ * 	the CACHE at all, it compares histograms of the digits, 2~3 times slower
+ * 	than 'scalar' in base-10. The kernel 'packed' is only used if selected.
+ * 	It stores each unique element of the CACHE once, and a 16-bit index per
+ * 	number, which makes the CACHE 4 times smaller at the cost of a second
+ * 	load. It only pays off when the CACHE doesn't fit in L2 but its index
+ * 	does. In bands where the fangs fit in 32 bits (up to 18 digits in
+ * 	base-10) 'avx512' & 'avx2' switch to 32-bit lanes, which check twice as
+ * 	many multiplicands per iteration. The kernels split the products in 3
+ * 	parts. The scalar kernels ('scalar', 'packed' & 'pdep') split them in 4
+ * 	when the CACHE of 3 parts wouldn't fit in the largest level of cpu
+ * 	cache, which keeps the CACHE small past 18 digits. 'avx512' & 'avx2'
+ * 	keep 3 parts, since their bands of 4 parts would run the scalar loop.
+ *
+ * Measured and rejected, see git log for the numbers:
+ * 	- A low-digit sieve with digit masks: slower than the CACHE loads.
+ * 	- Pruning multiplicands by the leading digits: almost nothing pruned.
+ * 	- Updating the multiplier state with borrows: slower than divisions.
+ * 	- Interleaving multipliers, prefetching: the loads already overlap.
+ * 	- Tiling multipliers x multiplicands: de0 is scattered in any order.
+ * 	- 4 parts when the CACHE of 3 fits in cpu cache: the carries cost more.
+ * 	- 4 parts per cache level, or 2 parts: no level is worth the carries.
+ * 	- A vector 'packed': two dependent gathers per element.
+ * 	- A runtime BASE: every % & / by BASE would become a division.
+ * 	- A bitmap of the products of a task: the vampires are too sparse.
  */
 
 #define CACHE true
@@ -105,9 +140,33 @@
  *
  * For bases above 255 adjust digit_t accordingly.
  * If 2^(ELEMENT_BITS/(BASE-1)) < ELEMENT_BITS/log2(BASE-1), then disable CACHE.
+ *
+ * The build can also make one executable per base (make bases, or
+ * HELSING_BASES in CMakeLists.txt), each with its own BASE, named
+ * helsing-base[N]. Then --base=N runs the one for base N, or exits with
+ * failure if it wasn't built; there is no generic slow path, see Kernels.
  */
 
+#ifndef BASE
 #define BASE 10
+#endif
+
+/*
+ * VAMP_BITS:
+ *
+ * 	The #bits of the vampire numbers. It can be set to 64(default) or 128.
+ * With 128 the products are unsigned __int128, which goes past 2^64 (20 digits
+ * in base-10), while the fangs stay 64-bit. The 128-bit arithmetic is slower,
+ * so it's only worth it for the intervals that don't fit in 64 bits.
+ *
+ * The CACHE grows with the length of the products, about 800MB at 24 digits
+ * in base-10 with the products in 3 parts. When that doesn't fit in the
+ * largest level of cpu cache, the scalar kernels split the products in 4
+ * parts instead, which takes 8MB, see Kernels. The lengths where the CACHE
+ * could overflow are checked with 'nocache', see kernel_band.
+ */
+
+#define VAMP_BITS 64
 
 /*
  * MAX_TASK_SIZE:
@@ -116,10 +175,10 @@
  *
  * 	Because there is no simple way to predict the amount of vampire numbers
  * for a given interval, MAX_TASK_SIZE can be used to limit the memory usage of
- * quicksort.
+ * the sort, see array_sort.
  *
- * Quicksort shouldn't use more memory than:
- * threads * (sizeof(array) + MAX_TASK_SIZE * sizeof(vamp_t) * max(n_fang_pairs))
+ * The radix sort needs a second array, so it shouldn't use more memory than:
+ * threads * (sizeof(array) + 2 * MAX_TASK_SIZE * sizeof(vamp_t) * max(n_fang_pairs))
  * See https://oeis.org/A094208 for max(n_fang_pairs).
  */
 
@@ -29,8 +29,13 @@
  * The following typedefs are used to explicate intent.
  */
 
-typedef unsigned long long vamp_t; // vampire type
-#define VAMP_MAX ULLONG_MAX
+#if VAMP_BITS == 128
+	typedef unsigned __int128 vamp_t; // vampire type
+	#define VAMP_MAX (~(vamp_t)0)
+#elif VAMP_BITS == 64
+	typedef unsigned long long vamp_t; // vampire type
+	#define VAMP_MAX ULLONG_MAX
+#endif
 
 typedef unsigned long fang_t; // fang type
 #define FANG_MAX ULONG_MAX
@@ -75,6 +80,14 @@ typedef uint8_t length_t;
 #error VERBOSE_LEVEL acceptable values are 0 ~ 4
 #endif
 
+#if (VAMP_BITS != 64 && VAMP_BITS != 128)
+#error VAMP_BITS acceptable values are 64 or 128
+#endif
+
+#if (VAMP_BITS == 128 && !defined(__SIZEOF_INT128__))
+#error VAMP_BITS 128 requires unsigned __int128
+#endif
+
 #if (MIN_FANG_PAIRS == 0)
 #error MIN_FANG_PAIRS must be larger than 0
 #endif
@@ -14,6 +14,7 @@
 #endif
 
 #if defined(STORE_RESULTS) && defined(CHECKSUM_RESULTS)
+#include <stdint.h>
 #include <openssl/evp.h>
 #include "hash.h"
 #endif
@@ -24,6 +25,7 @@
 
 #if defined(STORE_RESULTS) && defined(PRINT_RESULTS)
 #include <stdio.h>
+#include "helper.h"
 #endif
 
 #ifdef STORE_RESULTS
@@ -38,25 +40,137 @@ void array_free(struct array *ptr)
 #endif
 
 #ifdef PROCESS_RESULTS
-int cmpvampt(const void *a, const void *b)
+void arena_new(struct arena **ptr)
 {
-	vamp_t tmp_a = (*(vamp_t *) a);
-	vamp_t tmp_b = (*(vamp_t *) b);
-
-	if (tmp_a > tmp_b)
-		return 1;
-	else if (tmp_a < tmp_b)
-		return -1;
-	else
-		return 0;
+#if SANITY_CHECK
+	assert(ptr != NULL);
+	assert(*ptr == NULL);
+#endif
+
+	struct arena *new = malloc(sizeof(struct arena));
+	if (new == NULL)
+		abort();
+
+	new->buf = NULL;
+	new->size = 0;
+	new->spare = NULL;
+	*ptr = new;
 }
 
-void array_new(struct array **ptr, struct llnode *ll, vamp_t *count_ptr)
+void arena_free(struct arena *ptr)
+{
+	if (ptr == NULL)
+		return;
+
+	free(ptr->buf);
+	llnode_free(ptr->spare);
+	free(ptr);
+}
+
+/*
+ * arena_buf:
+ *
+ * Returns a buffer of at least size elements. It only grows, by at least 2x.
+ */
+
+static vamp_t *arena_buf(struct arena *ptr, vamp_t size)
+{
+	if (ptr->size < size) {
+		vamp_t new_size = ptr->size * 2;
+		if (new_size < size)
+			new_size = size;
+
+		free(ptr->buf);
+		ptr->buf = malloc(sizeof(vamp_t) * new_size);
+		if (ptr->buf == NULL)
+			abort();
+		ptr->size = new_size;
+	}
+	return ptr->buf;
+}
+
+/*
+ * array_sort:
+ *
+ * LSD radix sort, one byte per pass, of the numbers in ll into arr. The
+ * products of a task are in [lmin, lmax] and share their high bytes, so the
+ * passes over the bytes where all the numbers are the same are skipped.
+ *
+ * The first pass reads straight from ll, and the passes alternate between arr
+ * & the buffer of the arena, starting from whichever makes the last one end up
+ * in arr.
+ */
+
+#define RADIX_BITS 8
+#define RADIX_SIZE (1 << RADIX_BITS)
+#define RADIX_PASSES (sizeof(vamp_t) * 8 / RADIX_BITS)
+
+static void array_sort(vamp_t *arr, vamp_t size, struct llnode *ll, struct arena *arena)
+{
+	size_t count[RADIX_PASSES][RADIX_SIZE];
+	memset(count, 0, sizeof(count));
+
+	for (struct llnode *node = ll; node != NULL; node = node->next) {
+		for (vamp_t i = 0; i < node->logical_size; i++) {
+			vamp_t tmp = node->data[i];
+			for (size_t pass = 0; pass < RADIX_PASSES; pass++) {
+				count[pass][tmp & (RADIX_SIZE - 1)] += 1;
+				tmp >>= RADIX_BITS;
+			}
+		}
+	}
+
+	size_t passes[RADIX_PASSES];
+	size_t n_passes = 0;
+	for (size_t pass = 0; pass < RADIX_PASSES; pass++) {
+		size_t offset = 0;
+		for (size_t i = 0; i < RADIX_SIZE; i++) {
+			size_t tmp = count[pass][i];
+			if (tmp == size)
+				break;
+			count[pass][i] = offset;
+			offset += tmp;
+		}
+		if (offset != 0)
+			passes[n_passes++] = pass;
+	}
+
+	if (n_passes == 0) {
+		for (vamp_t i = 0; ll != NULL; ll = ll->next) {
+			memcpy(&(arr[i]), ll->data, (ll->logical_size) * sizeof(vamp_t));
+			i += ll->logical_size;
+		}
+		return;
+	}
+
+	vamp_t *buf = NULL;
+	if (n_passes > 1)
+		buf = arena_buf(arena, size);
+
+	vamp_t *dst = (n_passes % 2) ? arr : buf;
+	size_t shift = passes[0] * RADIX_BITS;
+	size_t *offset = count[passes[0]];
+	for (; ll != NULL; ll = ll->next)
+		for (vamp_t i = 0; i < ll->logical_size; i++)
+			dst[offset[(ll->data[i] >> shift) & (RADIX_SIZE - 1)]++] = ll->data[i];
+
+	for (size_t p = 1; p < n_passes; p++) {
+		vamp_t *src = dst;
+		dst = (src == arr) ? buf : arr;
+		shift = passes[p] * RADIX_BITS;
+		offset = count[passes[p]];
+		for (vamp_t i = 0; i < size; i++)
+			dst[offset[(src[i] >> shift) & (RADIX_SIZE - 1)]++] = src[i];
+	}
+}
+
+void array_new(struct array **ptr, struct llnode *ll, vamp_t *count_ptr, struct arena *arena)
 {
 #if SANITY_CHECK
 	assert(ptr != NULL);
 	assert(*ptr == NULL);
 	assert(count_ptr != NULL);
+	assert(arena != NULL);
 #endif
 	if (ll == NULL)
 		return;
@@ -65,18 +179,13 @@ void array_new(struct array **ptr, struct llnode *ll, vamp_t *count_ptr)
 	if (size == 0)
 		return;
 
+	// The sorted array is handed off to the task, it's not part of the arena.
 	vamp_t *arr = malloc(sizeof(vamp_t) * size);
 	if (arr == NULL)
 		abort();
 
-	// copy
-	for (vamp_t i = 0; ll != NULL; ll = ll->next) {
-		memcpy(&(arr[i]), ll->data, (ll->logical_size) * sizeof(vamp_t));
-		i += ll->logical_size;
-	}
-
 	// sort
-	qsort(arr, size, sizeof(vamp_t), cmpvampt);
+	array_sort(arr, size, ll, arena);
 
 	// filter fangs & resize
 	vamp_t count = 0;
@@ -124,16 +233,24 @@ void array_checksum(struct array *ptr, struct hash *checksum)
 		if (ptr->data[i] == 0)
 			continue;
 
+		/*
+		 * Big-endian, 8 bytes for the numbers below 2^64, so that the
+		 * checksums of VAMP_BITS 64 & 128 are the same.
+		 */
 		vamp_t tmp = ptr->data[i];
-
-		#if (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
-		tmp = __builtin_bswap64(tmp);
-		#endif
+		unsigned char bytes[sizeof(vamp_t)];
+		size_t size = sizeof(uint64_t);
+		if (tmp > UINT64_MAX)
+			size = sizeof(vamp_t);
+		for (size_t j = size; j > 0; j--) {
+			bytes[j - 1] = tmp & 0xff;
+			tmp >>= 8;
+		}
 
 		EVP_DigestInit_ex(checksum->mdctx, checksum->md, NULL);
 
 		EVP_DigestUpdate(checksum->mdctx, checksum->md_value, checksum->md_size);
-		EVP_DigestUpdate(checksum->mdctx, &tmp, sizeof(tmp));
+		EVP_DigestUpdate(checksum->mdctx, bytes, size);
 
 		EVP_DigestFinal_ex(checksum->mdctx, checksum->md_value, NULL);
 	}
@@ -151,7 +268,9 @@ void array_print(struct array *ptr, vamp_t count)
 		if (ptr->data[i] == 0)
 			continue;
 
-		fprintf(stdout, "%llu %llu\n", ++count, ptr->data[i]);
+		char count_str[VAMP_STR_SIZE];
+		char data_str[VAMP_STR_SIZE];
+		fprintf(stdout, "%s %s\n", vtostr(++count, count_str), vtostr(ptr->data[i], data_str));
 		fflush(stdout);
 	}
 }
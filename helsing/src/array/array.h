@@ -26,13 +26,60 @@ static inline void array_free(__attribute__((unused)) struct array *ptr)
 }
 #endif /* STORE_RESULTS */
 
+/*
+ * arena:
+ *
+ * The memory of a thread for collecting & sorting its results, reused from
+ * task to task. The nodes of the lists go back to spare instead of being
+ * freed, see llnode_add, and buf is the second array of the sort, see
+ * array_sort.
+ */
+
 #ifdef PROCESS_RESULTS
-void array_new(struct array **ptr, struct llnode *ll, vamp_t *count_ptr);
+struct arena
+{
+	vamp_t *buf;
+	vamp_t size;
+	struct llnode *spare;
+};
+void arena_new(struct arena **ptr);
+void arena_free(struct arena *ptr);
+static inline void arena_add(struct arena *ptr, struct llnode **ll, vamp_t value)
+{
+	llnode_add(ll, value, &(ptr->spare));
+}
+static inline void arena_recycle(struct arena *ptr, struct llnode *ll)
+{
+	llnode_recycle(&(ptr->spare), ll);
+}
+void array_new(struct array **ptr, struct llnode *ll, vamp_t *count_ptr, struct arena *arena);
 #else  /* PROCESS_RESULTS */
+struct arena
+{
+};
+static inline void arena_new(struct arena **ptr)
+{
+	*ptr = NULL;
+}
+static inline void arena_free(__attribute__((unused)) struct arena *ptr)
+{
+}
+static inline void arena_add(
+	__attribute__((unused)) struct arena *ptr,
+	__attribute__((unused)) struct llnode **ll,
+	__attribute__((unused)) vamp_t value)
+{
+}
+static inline void arena_recycle(
+	__attribute__((unused)) struct arena *ptr,
+	__attribute__((unused)) struct llnode *ll)
+{
+}
 static inline void array_new(
 	__attribute__((unused)) struct array **ptr,
 	__attribute__((unused)) struct llnode *ll,
-	__attribute__((unused)) vamp_t *count_ptr)
+	__attribute__((unused)) vamp_t *count_ptr,
+	__attribute__((unused)) struct arena *arena)
 {
 }
 #endif /* PROCESS_RESULTS */
@@ -34,19 +34,25 @@ int touch_checkpoint(struct options_t options, struct interval_t interval)
 		return 1;
 	}
 	fp = fopen(CHECKPOINT_FILE, "w+");
-	fprintf(fp, "%llu %llu\n", interval.min, interval.max);
+	char min_str[VAMP_STR_SIZE];
+	char max_str[VAMP_STR_SIZE];
+	fprintf(fp, "%s %s\n", vtostr(interval.min, min_str), vtostr(interval.max, max_str));
 	fclose(fp);
 	return 0;
 }
 
 static void err_baditem(vamp_t line, vamp_t item)
 {
-	fprintf(stderr, "\n[ERROR] %s line %llu item #%llu has bad data:\n", CHECKPOINT_FILE, line, item);
+	char line_str[VAMP_STR_SIZE];
+	char item_str[VAMP_STR_SIZE];
+	fprintf(stderr, "\n[ERROR] %s line %s item #%s has bad data:\n", CHECKPOINT_FILE, vtostr(line, line_str), vtostr(item, item_str));
 }
 
 static void err_conflict(vamp_t line, vamp_t item)
 {
-	fprintf(stderr, "\n[ERROR] %s line %llu item #%llu has conflicting data:\n", CHECKPOINT_FILE, line, item);
+	char line_str[VAMP_STR_SIZE];
+	char item_str[VAMP_STR_SIZE];
+	fprintf(stderr, "\n[ERROR] %s line %s item #%s has conflicting data:\n", CHECKPOINT_FILE, vtostr(line, line_str), vtostr(item, item_str));
 }
 
 static void err_unexpected_char(int ch, vamp_t line, vamp_t item)
@@ -85,8 +91,9 @@ static int concat_digit(vamp_t *number, int ch, vamp_t line, vamp_t item)
 	digit_t digit = ch - '0';
 
 	if (willoverflow(*number, VAMP_MAX, digit)) {
+		char max_str[VAMP_STR_SIZE];
 		err_baditem(line, item);
-		fprintf(stderr, "Out of interval: [0, %llu]\n", VAMP_MAX);
+		fprintf(stderr, "Out of interval: [0, %s]\n", vtostr(VAMP_MAX, max_str));
 		rc = 1;
 		goto out;
 	}
@@ -180,6 +187,8 @@ int load_checkpoint(struct interval_t *interval, struct taskboard *progress)
 	bool is_empty = true;
 	vamp_t num = 0;
 	int hash_index = 0;
+	char num_str[VAMP_STR_SIZE];
+	char limit_str[VAMP_STR_SIZE];
 
 	while (!rc) {
 		int ch = fgetc(fp);
@@ -219,17 +228,17 @@ int load_checkpoint(struct interval_t *interval, struct taskboard *progress)
 				case complete:
 					if (num < interval->min) {
 						err_conflict(line, item);
-						fprintf(stderr, "%llu < %llu (below min)\n", num, interval->min);
+						fprintf(stderr, "%s < %s (below min)\n", vtostr(num, num_str), vtostr(interval->min, limit_str));
 						rc = 1;
 					}
 					else if (num > interval->max) {
 						err_conflict(line, item);
-						fprintf(stderr, "%llu > %llu (above max)\n", num, interval->max);
+						fprintf(stderr, "%s > %s (above max)\n", vtostr(num, num_str), vtostr(interval->max, limit_str));
 						rc = 1;
 					}
 					else if (num <= interval->complete && line != 2) {
 						err_conflict(line, item);
-						fprintf(stderr, "%llu <= %llu (below previous)\n", num, interval->complete);
+						fprintf(stderr, "%s <= %s (below previous)\n", vtostr(num, num_str), vtostr(interval->complete, limit_str));
 						rc = 1;
 					} else {
 						rc = interval_set_complete(interval, num);
@@ -239,7 +248,7 @@ int load_checkpoint(struct interval_t *interval, struct taskboard *progress)
 				case count:
 					if (num < progress->common_count && line != 2) {
 						err_conflict(line, item);
-						fprintf(stderr, "%llu < %llu (below previous)\n", num, progress->common_count);
+						fprintf(stderr, "%s < %s (below previous)\n", vtostr(num, num_str), vtostr(progress->common_count, limit_str));
 						rc = 1;
 					}
 #ifdef PROCESS_RESULTS
@@ -292,7 +301,9 @@ void save_checkpoint(vamp_t complete, struct taskboard *progress)
 	FILE *fp = fopen(CHECKPOINT_FILE, "a");
 	assert(fp != NULL);
 
-	fprintf(fp, "%llu %llu", complete, progress->common_count);
+	char complete_str[VAMP_STR_SIZE];
+	char count_str[VAMP_STR_SIZE];
+	fprintf(fp, "%s %s", vtostr(complete, complete_str), vtostr(progress->common_count, count_str));
 
 #ifdef CHECKSUM_RESULTS
 	fprintf(fp, " ");
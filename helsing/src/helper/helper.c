@@ -9,6 +9,7 @@
 
 #include "configuration.h"
 #include "configuration_adv.h"
+#include "helper.h"
 
 /*
  * willoverflow:
@@ -72,25 +73,72 @@ vamp_t div_roof(vamp_t x, vamp_t y)
 	return (x/y + !!(x%y));
 }
 
+fang_t sqrtv_floor(vamp_t x) // vamp_t sqrt to fang_t.
+{
+	vamp_t x2 = x / 2;
+	vamp_t root = x2;
+	if (root > 0) {
+		vamp_t tmp = (root + x / root) / 2;
+		while (tmp < root) {
+			root = tmp;
+			tmp = (root + x / root) / 2;
+		}
+		return root;
+	}
+	return x;
+}
+
+fang_t sqrtv_roof(vamp_t x)
+{
+	if (x == 0)
+		return 0;
+
+	fang_t root = sqrtv_floor(x);
+	if (root == FANG_MAX)
+		return root;
+
+	return (x / root);
+}
+
 /*
- * partition3:
+ * partition:
  *
- * partition x into 3 integers so that:
- * x <= 2 * A + B
+ * partition x into parts integers so that:
+ * x <= (parts - 1) * A + B
  * and return A.
  */
 
-length_t partition3(length_t x)
+length_t partition(length_t x, length_t parts)
 {
-	length_t ret = x / 3;
+	length_t ret = x / parts;
 
-	// adjust for product iterator
+	// adjust for product iterator, which is split in parts - 1
 	length_t n = x / 2;
-	if (ret < n + 1 - ret)
-		ret = n + 1 - ret;
+	if (ret < (n + parts - 1) / (parts - 1))
+		ret = (n + parts - 1) / (parts - 1);
 
 	if (ret == 0)
 		ret = 1;
 
 	return ret;
 }
+
+/*
+ * vtostr:
+ *
+ * Writes x in base-10 to the end of str, which must be at least VAMP_STR_SIZE
+ * chars, and returns a pointer to the first digit. printf has no conversion
+ * for unsigned __int128, see VAMP_BITS.
+ */
+
+char *vtostr(vamp_t x, char *str)
+{
+	char *ptr = &(str[VAMP_STR_SIZE - 1]);
+	*ptr = '\0';
+	do {
+		ptr--;
+		*ptr = '0' + x % 10;
+		x /= 10;
+	} while (x > 0);
+	return ptr;
+}
@@ -10,12 +10,17 @@
 
 #include "configuration_adv.h"
 
+#define VAMP_STR_SIZE 40 // length(VAMP_MAX) in base-10 + 1
+
 bool willoverflow(vamp_t x, vamp_t limit, digit_t digit);
 length_t length(vamp_t x);
 vamp_t pow_v(length_t exponent);
 vamp_t get_min(vamp_t min, vamp_t max);
 vamp_t get_max(vamp_t min, vamp_t max);
 vamp_t div_roof(vamp_t x, vamp_t y);
-length_t partition3(length_t x);
+fang_t sqrtv_floor(vamp_t x);
+fang_t sqrtv_roof(vamp_t x);
+length_t partition(length_t x, length_t parts);
+char *vtostr(vamp_t x, char *str);
 
 #endif /* HELPER_HELSING */
@@ -8,11 +8,12 @@
 #include "configuration_adv.h"
 #include "helper.h"
 #include "interval.h"
-#include "cache.h"
 
 int interval_set(struct interval_t *ptr, vamp_t min, vamp_t max)
 {
 	int rc = 0;
+	char old_str[VAMP_STR_SIZE];
+	char new_str[VAMP_STR_SIZE];
 	if (min > max) {
 		fprintf(stderr, "Invalid arguments, min <= max\n");
 		rc = 1;
@@ -21,29 +22,11 @@ int interval_set(struct interval_t *ptr, vamp_t min, vamp_t max)
 
 	ptr->min = get_min(min, max);
 	if (min != ptr->min)
-		fprintf(stderr, "Adjusted min from %llu to %llu\n", min, ptr->min);
+		fprintf(stderr, "Adjusted min from %s to %s\n", vtostr(min, old_str), vtostr(ptr->min, new_str));
 
 	ptr->max = get_max(ptr->min, max);
 	if (max != ptr->max)
-		fprintf(stderr, "Adjusted max from %llu to %llu\n", max, ptr->max);
-
-	if (cache_ovf_chk(ptr->max)) {
-		fprintf(stderr, "WARNING: the code might produce false positives, ");
-		if (USE_PDEP) {
-			fprintf(stderr, "please set USE_PDEP to false.\n");
-		}
-		else if (DEDICATED_BITFIELDS) {
-			fprintf(stderr, "please set DEDICATED_BITFIELDS to false.\n");
-		}
-		else if (COMPARISON_BITS == 32) {
-			fprintf(stderr, "please set COMPARISON_BITS to 64.\n");
-		}
-		else {
-			fprintf(stderr, "please set CACHE to false.\n");
-		}
-		rc = 1;
-		goto out;
-	}
+		fprintf(stderr, "Adjusted max from %s to %s\n", vtostr(max, old_str), vtostr(ptr->max, new_str));
 
 	ptr->complete = 0;
 	if (ptr->complete < ptr->min)
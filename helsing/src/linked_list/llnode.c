@@ -54,18 +54,27 @@ void llnode_free(struct llnode *node)
 	}
 }
 
-void llnode_add(struct llnode **ptr, vamp_t value)
+/*
+ * llnode_add:
+ *
+ * The new nodes are taken from spare, if it has any, see llnode_recycle.
+ */
+
+void llnode_add(struct llnode **ptr, vamp_t value, struct llnode **spare)
 {
 #if SANITY_CHECK
 	assert(ptr != NULL);
+	assert(spare != NULL);
 	assert(value != 0);
 #endif
-	if (*ptr == NULL) {
-		llnode_new(ptr, NULL);
-	}
-	else if ((*ptr)->logical_size >= LINK_SIZE) {
-		struct llnode *new = NULL;
-		llnode_new(&new, *ptr);
+	if (*ptr == NULL || (*ptr)->logical_size >= LINK_SIZE) {
+		struct llnode *new = *spare;
+		if (new != NULL) {
+			*spare = new->next;
+			new->next = *ptr;
+		} else {
+			llnode_new(&new, *ptr);
+		}
 		*ptr = new;
 	}
 	(*ptr)->data[(*ptr)->logical_size] = value;
@@ -80,4 +89,40 @@ vamp_t llnode_getsize(struct llnode *ptr)
 
 	return size;
 }
+
+/*
+ * llnode_recycle:
+ *
+ * Empties the nodes of list and moves them to spare.
+ */
+
+void llnode_recycle(struct llnode **spare, struct llnode *list)
+{
+	for (struct llnode *i = list; i != NULL; i = i->next)
+		i->logical_size = 0;
+
+	llnode_concat(spare, list);
+}
+
+/*
+ * llnode_concat:
+ *
+ * Moves the nodes of list in front of *ptr.
+ */
+
+void llnode_concat(struct llnode **ptr, struct llnode *list)
+{
+#if SANITY_CHECK
+	assert(ptr != NULL);
+#endif
+	if (list == NULL)
+		return;
+
+	struct llnode *tail = list;
+	while (tail->next != NULL)
+		tail = tail->next;
+
+	tail->next = *ptr;
+	*ptr = list;
+}
 #endif /* PROCESS_RESULTS */
\ No newline at end of file
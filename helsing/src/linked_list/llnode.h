@@ -16,8 +16,10 @@ struct llnode
 	struct llnode *next;
 };
 void llnode_free(struct llnode *list);
-void llnode_add(struct llnode **ptr, vamp_t value);
+void llnode_add(struct llnode **ptr, vamp_t value, struct llnode **spare);
+void llnode_recycle(struct llnode **spare, struct llnode *list);
 vamp_t llnode_getsize(struct llnode *ptr);
+void llnode_concat(struct llnode **ptr, struct llnode *list);
 #else /* PROCESS_RESULTS */
 struct llnode
 {
@@ -27,12 +29,23 @@ static inline void llnode_free(__attribute__((unused)) struct llnode *list)
 }
 static inline void llnode_add(
 	__attribute__((unused)) struct llnode **ptr,
-	__attribute__((unused)) vamp_t value)
+	__attribute__((unused)) vamp_t value,
+	__attribute__((unused)) struct llnode **spare)
+{
+}
+static inline void llnode_recycle(
+	__attribute__((unused)) struct llnode **spare,
+	__attribute__((unused)) struct llnode *list)
 {
 }
 static inline vamp_t llnode_getsize(__attribute__((unused)) struct llnode *ptr)
 {
 	return 0;
 }
+static inline void llnode_concat(
+	__attribute__((unused)) struct llnode **ptr,
+	__attribute__((unused)) struct llnode *list)
+{
+}
 #endif /* PROCESS_RESULTS */
 #endif /* HELSING_LLNODE_H */
\ No newline at end of file
@@ -16,6 +16,8 @@
 #include "checkpoint.h"
 #include "interval.h"
 #include "options.h"
+#include "kernel.h"
+#include "cache.h"
 
 static vamp_t get_lmax(vamp_t lmin, vamp_t max)
 {
@@ -46,6 +48,7 @@ int main(int argc, char *argv[])
 	if (load_checkpoint(&interval, progress))
 		goto out;
 
+	pthread_t writer;
 	pthread_t *threads = malloc(sizeof(pthread_t) * options.threads);
 	if (threads == NULL)
 		abort();
@@ -60,11 +63,19 @@ int main(int argc, char *argv[])
 		if (progress->size == 0)
 			continue;
 
-		fprintf(stderr, "Checking interval: [%llu, %llu]\n", lmin, lmax);
+		char lmin_str[VAMP_STR_SIZE];
+		char lmax_str[VAMP_STR_SIZE];
+		fprintf(stderr, "Checking interval: [%s, %s]\n", vtostr(lmin, lmin_str), vtostr(lmax, lmax_str));
+		if (progress->kernel != options.kernel)
+			fprintf(stderr, "The CACHE might produce false positives, using the kernel %s\n", progress->kernel->name);
+		else if (progress->kernel->cache && cache_parts(thhandle->digptr, lmax) == 4)
+			fprintf(stderr, "The CACHE doesn't fit in the cpu cache, splitting the products in 4 parts\n");
+		assert(pthread_create(&writer, NULL, taskboard_write, (void *)progress) == 0);
 		for (thread_t thread = 0; thread < options.threads; thread++)
 			assert(pthread_create(&threads[thread], NULL, thread_function, (void *)(thhandle->targs[thread])) == 0);
 		for (thread_t thread = 0; thread < options.threads; thread++)
 			pthread_join(threads[thread], 0);
+		pthread_join(writer, 0);
 	}
 	targs_handle_print(thhandle);
 	targs_handle_free(thhandle);
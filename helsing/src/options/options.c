@@ -6,6 +6,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <string.h>
 #include <assert.h>
 #include <ctype.h> // isdigit
 #include <getopt.h>
@@ -15,8 +16,9 @@
 #include "configuration_adv.h"
 #include "options.h"
 #include "helper.h"
+#include "kernel.h"
 
-static void buildconf()
+static void buildconf(struct options_t *ptr)
 {
 	printf("  configuration:\n");
 	printf("    VERBOSE_LEVEL=%d\n", VERBOSE_LEVEL);
@@ -32,12 +34,27 @@ static void buildconf()
 		printf("    USE_PDEP=%s\n", (USE_PDEP ? "true" : "false"));
 	}
 	printf("    BASE=%d\n", BASE);
+	printf("    VAMP_BITS=%d\n", VAMP_BITS);
 	printf("    MAX_TASK_SIZE=%llu\n", MAX_TASK_SIZE);
 	printf("    USE_CHECKPOINT=%s\n", (USE_CHECKPOINT ? "true" : "false"));
 	if (USE_CHECKPOINT)
 		printf("    CHECKPOINT_FILE=%s\n", CHECKPOINT_FILE);
 	printf("    LINK_SIZE=%d\n", LINK_SIZE);
 	printf("    SANITY_CHECK=%s\n", (SANITY_CHECK ? "true" : "false"));
+	printf("  runtime:\n");
+	printf("    kernel=%s\n", ptr->kernel->name);
+	printf("    tasks=%s\n", (ptr->fang_tasks ? "fang" : "product"));
+}
+
+static void arg_base()
+{
+	printf("    --base=N       run helsing-baseN, if it was built, see BASE in configuration.h\n");
+}
+
+static void arg_kernel()
+{
+	printf("    --kernel=name  select kernel:");
+	kernel_print_names();
 }
 
 static void arg_lower_bound()
@@ -70,8 +87,11 @@ static void help()
 	printf("Usage: helsing [options] [interval options]\n");
 	printf("Scan a given interval for vampire numbers.\n");
 	printf("\nOptions:\n");
+	arg_base();
 	printf("    --buildconf    show build configuration\n");
+	printf("    --fang-tasks   split tasks by multiplier instead of product\n");
 	printf("    --help         show help\n");
+	arg_kernel();
 	printf("    --progress     display progress\n");
 	arg_manual_task_size();
 	arg_threads();
@@ -108,8 +128,11 @@ static int strtov(const char *str, vamp_t min, vamp_t max, vamp_t *number) // st
 	}
 	*number = tmp;
 out:
-	if (err)
-		fprintf(stderr, "Input out of range: [%llu, %llu]\n", min, max);
+	if (err) {
+		char min_str[VAMP_STR_SIZE];
+		char max_str[VAMP_STR_SIZE];
+		fprintf(stderr, "Input out of range: [%s, %s]\n", vtostr(min, min_str), vtostr(max, max_str));
+	}
 	return err;
 }
 
@@ -121,29 +144,90 @@ static length_t get_max_length()
 	return ret;
 }
 
+/*
+ * base_exec:
+ *
+ * BASE is fixed at compile time, see configuration.h. If --base=N asks for
+ * another base, we replace ourselves with helsing-baseN from the same
+ * directory (or PATH), with the same arguments. It has to happen before
+ * getopt, because -n depends on the base.
+ *
+ * Only the bases that were built (BASES in the Makefile, HELSING_BASES in
+ * CMakeLists.txt) can be selected. There is no generic fallback, see BASE in
+ * configuration.h. If we can't run helsing-baseN, we exit with failure, so
+ * that job scripts can tell.
+ */
+
+static void base_exec(int argc, char *argv[])
+{
+	const char *str = NULL;
+	for (int i = 1; i < argc && str == NULL; i++) {
+		if (strncmp(argv[i], "--base=", strlen("--base=")) == 0)
+			str = argv[i] + strlen("--base=");
+		else if (strcmp(argv[i], "--base") == 0 && i + 1 < argc)
+			str = argv[i + 1];
+		else if (strcmp(argv[i], "--") == 0)
+			break;
+	}
+	if (str == NULL)
+		return;
+
+	vamp_t base;
+	if (strtov(str, 2, UINT8_MAX, &base))
+		exit(EXIT_FAILURE);
+	if (base == BASE)
+		return;
+
+	char path[4096];
+	const char *slash = strrchr(argv[0], '/');
+	int dir = (slash == NULL) ? 0 : slash - argv[0] + 1;
+	int len = snprintf(path, sizeof(path), "%.*shelsing-base%u", dir, argv[0], (unsigned)base);
+	if (len < 0 || (size_t)len >= sizeof(path)) {
+		fprintf(stderr, "The path of helsing-base%u is too long\n", (unsigned)base);
+		exit(EXIT_FAILURE);
+	}
+
+	if (slash == NULL)
+		execvp(path, argv);
+	else
+		execv(path, argv);
+
+	fprintf(stderr, "Couldn't run %s for --base=%u, see BASE in configuration.h\n", path, (unsigned)base);
+	exit(EXIT_FAILURE);
+}
+
 int options_init(struct options_t* ptr, int argc, char *argv[], vamp_t *min, vamp_t *max)
 {
 	ptr->threads = 1;
 	ptr->manual_task_size = 0;
 	ptr->display_progress = false;
 	ptr->load_checkpoint = false;
+	ptr->fang_tasks = false;
+	ptr->kernel = kernel_best();
 
 #ifdef _SC_NPROCESSORS_ONLN
 	ptr->threads = sysconf(_SC_NPROCESSORS_ONLN);
 #endif
 
+	base_exec(argc, argv);
+
 	int rc = 0;
+
 	static int buildconf_flag = 0;
 	static int help_flag = 0;
 	static int display_progress = 0;
+	static int fang_tasks = 0;
 	bool min_is_set = false;
 	bool max_is_set = false;
 
 	int c;
 	while (1) {
 		static struct option long_options[] = {
+			{"base", required_argument, NULL, 'b'},
 			{"buildconf", no_argument, &buildconf_flag, 1},
+			{"fang-tasks", no_argument, &fang_tasks, 1},
 			{"help", no_argument, &help_flag, 1},
+			{"kernel", required_argument, NULL, 'k'},
 			{"progress", no_argument, &display_progress, 1},
 			{"lower bound", required_argument, NULL, 'l'},
 			{"n digits", required_argument, NULL, 'n'},
@@ -160,11 +244,6 @@ int options_init(struct options_t* ptr, int argc, char *argv[], vamp_t *min, vam
 		if (c == -1)
 			break;
 
-		if (buildconf_flag) {
-			buildconf();
-			rc = 1;
-			goto out;
-		}
 		if (help_flag) {
 			help();
 			rc = 1;
@@ -175,6 +254,18 @@ int options_init(struct options_t* ptr, int argc, char *argv[], vamp_t *min, vam
 			case 0:
 				break;
 
+			case 'b':
+				// See base_exec
+				break;
+
+			case 'k':
+				ptr->kernel = kernel_get(optarg);
+				if (ptr->kernel == NULL) {
+					printf("Unknown or unsupported kernel: %s\n", optarg);
+					arg_kernel();
+					rc = 1;
+				}
+				break;
 			case 'l':
 				if (min_is_set) {
 					help();
@@ -240,6 +331,15 @@ int options_init(struct options_t* ptr, int argc, char *argv[], vamp_t *min, vam
 			goto out;
 	}
 
+	if (fang_tasks)
+		ptr->fang_tasks = true;
+
+	if (buildconf_flag) {
+		buildconf(ptr);
+		rc = 1;
+		goto out;
+	}
+
 	if (optind < argc) {
 		printf ("non-option ARGV-elements: ");
 		while (optind < argc)
@@ -10,6 +10,8 @@
 
 #include "configuration_adv.h"
 
+struct kernel;
+
 struct options_t
 {
 	vamp_t min;
@@ -18,6 +20,8 @@ struct options_t
 	vamp_t manual_task_size;
 	bool display_progress;
 	bool load_checkpoint;
+	bool fang_tasks; // Split the tasks by multiplier, instead of product.
+	const struct kernel *kernel;
 };
 
 int options_init(struct options_t* ptr, int argc, char *argv[], vamp_t *min, vamp_t *max);
@@ -16,7 +16,7 @@
 #include <assert.h>
 #endif
 
-void task_new(struct task **ptr, vamp_t lmin, vamp_t lmax)
+void task_new(struct task **ptr, vamp_t lmin, vamp_t lmax, fang_t fmin, fang_t fmax)
 {
 #if SANITY_CHECK
 	assert(ptr != NULL);
@@ -29,9 +29,12 @@ void task_new(struct task **ptr, vamp_t lmin, vamp_t lmax)
 
 	new->lmin = lmin;
 	new->lmax = lmax;
+	new->fmin = fmin;
+	new->fmax = fmax;
 	new->result = NULL;
+	new->raw = NULL;
 	new->count = 0;
-	new->complete = false;
+	atomic_init(&(new->complete), false);
 	*ptr = new;
 }
 
@@ -41,6 +44,7 @@ void task_free(struct task *ptr)
 		return;
 
 	array_free(ptr->result);
+	llnode_free(ptr->raw);
 	free(ptr);
 }
 
@@ -51,8 +55,10 @@ void task_copy_vargs(struct task *ptr, struct vargs *vamp_args)
 	assert(vamp_args != NULL);
 #endif
 	ptr->result = vamp_args->result;
+	ptr->raw = vamp_args->raw;
 	ptr->count = vamp_args->local_count;
-	ptr->complete = true;
 
 	vamp_args->result = NULL;
+	vamp_args->raw = NULL;
+	atomic_store_explicit(&(ptr->complete), true, memory_order_release);
 }
\ No newline at end of file
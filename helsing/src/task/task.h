@@ -7,27 +7,35 @@
 #define HELSING_TASK_H
 
 #include <stdbool.h>
+#include <stdatomic.h>
 #include "configuration_adv.h"
 #include "vargs.h"
 #include "array.h"
+#include "llnode.h"
 
 /*
  * task:
  *
  * A task consists of a closed interval [lmin, lmax] and a pointer to an array,
  * where the results will be stored.
+ *
+ * Only the multipliers in [fmin, fmax] are checked. Fang tasks share the same
+ * [lmin, lmax] and keep their results unprocessed in raw.
  */
 
 struct task
 {
 	vamp_t lmin; // local minimum
 	vamp_t lmax; // local maximum
+	fang_t fmin;
+	fang_t fmax;
 	struct array *result;
+	struct llnode *raw;
 	vamp_t count;
-	bool complete;
+	atomic_bool complete; // Set last by the worker thread, see taskboard_write.
 };
 
-void task_new(struct task **ptr, vamp_t lmin, vamp_t lmax);
+void task_new(struct task **ptr, vamp_t lmin, vamp_t lmax, fang_t fmin, fang_t fmax);
 void task_free(struct task *ptr);
 void task_copy_vargs(struct task *ptr, struct vargs *vamp_args);
 #endif /* HELSING_TASK_H */
\ No newline at end of file
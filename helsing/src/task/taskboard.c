@@ -8,6 +8,7 @@
 #include <limits.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <math.h>
 
 #include "configuration.h"
 #include "configuration_adv.h"
@@ -17,6 +18,8 @@
 #include "taskboard.h"
 #include "checkpoint.h"
 #include "hash.h"
+#include "llnode.h"
+#include "kernel.h"
 
 void taskboard_new(struct taskboard **ptr, struct options_t options)
 {
@@ -25,18 +28,21 @@ void taskboard_new(struct taskboard **ptr, struct options_t options)
 	assert(*ptr == NULL);
 #endif
 
-	struct taskboard *new = malloc(sizeof(struct taskboard));
+	struct taskboard *new = aligned_alloc(TASKBOARD_LINE, sizeof(struct taskboard));
 	if (new == NULL)
 		abort();
 
 	new->options = options;
 	new->tasks = NULL;
 	new->size = 0;
-	new->todo = 0;
+	atomic_init(&(new->todo), 0);
 	new->fmax = 0;
+	new->kernel = options.kernel;
 	new->done = 0;
 	new->common_count = 0;
 	new->checksum = NULL;
+	new->raw = NULL;
+	sem_init(&(new->completed), 0, 0);
 	hash_new(&(new->checksum));
 	*ptr = new;
 }
@@ -52,6 +58,8 @@ void taskboard_free(struct taskboard *ptr)
 		free(ptr->tasks);
 	}
 	hash_free(ptr->checksum);
+	llnode_free(ptr->raw);
+	sem_destroy(&(ptr->completed));
 	free(ptr);
 }
 
@@ -71,6 +79,118 @@ static vamp_t get_interval_size(struct options_t options, vamp_t lmin, vamp_t lm
 	return interval_size;
 }
 
+static void set_product_tasks(struct taskboard *ptr, vamp_t lmin, vamp_t lmax)
+{
+	vamp_t interval_size = get_interval_size(ptr->options, lmin, lmax);
+
+	ptr->size = div_roof((lmax - lmin + 1), interval_size + (interval_size < VAMP_MAX));
+	ptr->tasks = malloc(sizeof(struct task *) * ptr->size);
+	if (ptr->tasks == NULL)
+		abort();
+
+	for (vamp_t i = 0; i < ptr->size; i++)
+		ptr->tasks[i] = NULL;
+
+	vamp_t x = 0;
+	vamp_t iterator = interval_size;
+	for (vamp_t i = lmin; i <= lmax; i += iterator + 1) {
+		if (lmax - i < interval_size)
+			iterator = lmax - i;
+
+		task_new(&(ptr->tasks[x]), i, i + iterator, 0, ptr->fmax);
+
+		x++;
+		if (i == lmax)
+			break;
+		if (i + iterator == VAMP_MAX)
+			break;
+	}
+	ptr->tasks[ptr->size - 1]->lmax = lmax;
+}
+
+/*
+ * fang_work:
+ *
+ * Estimates the work of the multipliers in [sqrt(lmin), x], with the integral
+ * of the number of multiplicands per multiplier:
+ * 	x - lmin / x      if x <= sqrt(lmax)
+ * 	(lmax - lmin) / x if x > sqrt(lmax)
+ */
+
+static long double fang_work(vamp_t lmin, vamp_t lmax, fang_t x)
+{
+	long double min = lmin;
+	long double max = lmax;
+	long double root = sqrtl(max);
+	long double ret = 0.0;
+
+	if (x <= root) {
+		ret = (long double)x * x / 2 - min * logl(x);
+	} else {
+		ret = root * root / 2 - min * logl(root);
+		ret += (max - min) * (logl(x) - logl(root));
+	}
+	return ret;
+}
+
+/*
+ * set_fang_tasks:
+ *
+ * Split [sqrt(lmin), fmax] into tasks of about equal work. Every task checks
+ * the whole [lmin, lmax], so the same product may come from different tasks,
+ * and the results can only be processed once all of them are complete.
+ * With -s the tasks have a fixed number of multipliers instead.
+ */
+
+static void set_fang_tasks(struct taskboard *ptr, vamp_t lmin, vamp_t lmax)
+{
+	fang_t fmin = sqrtv_roof(lmin);
+	if (fmin > ptr->fmax)
+		return;
+
+	vamp_t multipliers = ptr->fmax - fmin + 1;
+	vamp_t size = 4 * ptr->options.threads + 2;
+	if (ptr->options.manual_task_size != 0)
+		size = div_roof(multipliers, ptr->options.manual_task_size);
+	if (size > multipliers)
+		size = multipliers;
+
+	ptr->tasks = malloc(sizeof(struct task *) * size);
+	if (ptr->tasks == NULL)
+		abort();
+
+	long double work_min = fang_work(lmin, lmax, fmin);
+	long double work = fang_work(lmin, lmax, ptr->fmax) - work_min;
+
+	fang_t task_min = fmin;
+	for (vamp_t i = 1; i <= size; i++) {
+		fang_t task_max = ptr->fmax;
+		if (i < size && ptr->options.manual_task_size != 0) {
+			task_max = task_min + (ptr->options.manual_task_size - 1);
+		} else if (i < size) {
+			// Binary search for the last multiplier of the task.
+			long double target = work_min + work * i / size;
+			fang_t low = task_min;
+			fang_t high = ptr->fmax;
+			while (low < high) {
+				fang_t mid = low + (high - low) / 2;
+				if (fang_work(lmin, lmax, mid) < target)
+					low = mid + 1;
+				else
+					high = mid;
+			}
+			task_max = low;
+		}
+		ptr->tasks[ptr->size] = NULL;
+		task_new(&(ptr->tasks[ptr->size]), lmin, lmax, task_min, task_max);
+		ptr->size += 1;
+
+		if (task_max == ptr->fmax)
+			break;
+		task_min = task_max + 1;
+	}
+}
+
 void taskboard_set(struct taskboard *ptr, vamp_t lmin, vamp_t lmax)
 {
 	assert(ptr->done == ptr->size);
@@ -79,9 +199,10 @@ void taskboard_set(struct taskboard *ptr, vamp_t lmin, vamp_t lmax)
 	free(ptr->tasks);
 	ptr->tasks = NULL;
 	ptr->size = 0;
-	ptr->todo = 0;
+	atomic_store_explicit(&(ptr->todo), 0, memory_order_relaxed);
 	ptr->done = 0;
 	ptr->fmax = 0;
+	ptr->kernel = kernel_band(ptr->options.kernel, lmax);
 
 	assert(lmin <= lmax);
 
@@ -101,48 +222,62 @@ void taskboard_set(struct taskboard *ptr, vamp_t lmin, vamp_t lmax)
 		else if (fmaxsquare < lmax)
 			lmax = fmaxsquare; // Max can be bigger than fmax^2: BASE^(2n) - 1 > (BASE^n - 1) ^ 2
 	}
-	vamp_t interval_size = get_interval_size(ptr->options, lmin, lmax);
 
-	ptr->size = div_roof((lmax - lmin + 1), interval_size + (interval_size < VAMP_MAX));
-	ptr->tasks = malloc(sizeof(struct task *) * ptr->size);
-	if (ptr->tasks == NULL)
-		abort();
-
-	for (vamp_t i = 0; i < ptr->size; i++)
-		ptr->tasks[i] = NULL;
+	if (ptr->options.fang_tasks)
+		set_fang_tasks(ptr, lmin, lmax);
+	else
+		set_product_tasks(ptr, lmin, lmax);
+}
 
-	vamp_t x = 0;
-	vamp_t iterator = interval_size;
-	for (vamp_t i = lmin; i <= lmax; i += iterator + 1) {
-		if (lmax - i < interval_size)
-			iterator = lmax - i;
+/*
+ * taskboard_get_task:
+ *
+ * Called by the worker threads. The tasks are set before the threads start,
+ * so taking one is a single fetch-add, and todo goes past size once they run
+ * out.
+ */
 
-		task_new(&(ptr->tasks[x]), i, i + iterator);
+struct task *taskboard_get_task(struct taskboard *ptr)
+{
+	size_t todo = atomic_fetch_add_explicit(&(ptr->todo), 1, memory_order_relaxed);
+	if (todo < ptr->size)
+		return ptr->tasks[todo];
 
-		x++;
-		if (i == lmax)
-			break;
-		if (i + iterator == VAMP_MAX)
-			break;
-	}
-	ptr->tasks[ptr->size - 1]->lmax = lmax;
+	return NULL;
 }
 
-struct task *taskboard_get_task(struct taskboard *ptr)
+/*
+ * taskboard_merge:
+ *
+ * Process the results of all the fang tasks at once, so that the vampire
+ * numbers with fang pairs in different tasks are only counted once.
+ */
+
+static void taskboard_merge(struct taskboard *ptr)
 {
-	struct task *ret = NULL;
-	if (ptr->todo < ptr->size) {
-		ret = ptr->tasks[ptr->todo];
-		ptr->todo += 1;
+	struct array *result = NULL;
+	vamp_t count = 0;
+	struct arena *arena = NULL;
+
+	arena_new(&arena);
+	array_new(&result, ptr->raw, &count, arena);
+	arena_free(arena);
+	llnode_free(ptr->raw);
+	ptr->raw = NULL;
+
+	if (result != NULL) {
+		array_print(result, ptr->common_count);
+		array_checksum(result, ptr->checksum);
 	}
-	return ret;
+	ptr->common_count += count;
+	array_free(result);
 }
 
-void taskboard_cleanup(struct taskboard *ptr)
+static void taskboard_cleanup(struct taskboard *ptr)
 {
 	while (
 		ptr->done < ptr->size &&
-		ptr->tasks[ptr->done]->complete != false)
+		atomic_load_explicit(&(ptr->tasks[ptr->done]->complete), memory_order_acquire))
 	{
 		if (ptr->tasks[ptr->done]->result != NULL) {
 			array_print(ptr->tasks[ptr->done]->result, ptr->common_count);
@@ -150,7 +285,17 @@ void taskboard_cleanup(struct taskboard *ptr)
 		}
 		ptr->common_count += ptr->tasks[ptr->done]->count;
 		taskboard_progress(ptr);
-		save_checkpoint(ptr->tasks[ptr->done]->lmax, ptr);
+
+		if (ptr->options.fang_tasks) {
+			llnode_concat(&(ptr->raw), ptr->tasks[ptr->done]->raw);
+			ptr->tasks[ptr->done]->raw = NULL;
+			if (ptr->done + 1 == ptr->size) {
+				taskboard_merge(ptr);
+				save_checkpoint(ptr->tasks[ptr->done]->lmax, ptr);
+			}
+		} else {
+			save_checkpoint(ptr->tasks[ptr->done]->lmax, ptr);
+		}
 
 		task_free(ptr->tasks[ptr->done]);
 		ptr->tasks[ptr->done] = NULL;
@@ -158,21 +303,60 @@ void taskboard_cleanup(struct taskboard *ptr)
 	}
 }
 
+/*
+ * taskboard_complete:
+ *
+ * Called by the worker threads. They hand their results to the task and
+ * return to the fang search, without waiting on the I/O of taskboard_write.
+ */
+
+void taskboard_complete(struct taskboard *ptr, struct task *task, struct vargs *vamp_args)
+{
+	task_copy_vargs(task, vamp_args);
+	sem_post(&(ptr->completed));
+}
+
+/*
+ * taskboard_write:
+ *
+ * The writer thread of a band. The tasks are completed in any order, while
+ * their results are printed, hashed & checkpointed in order. Each completed
+ * task posts once, so after size posts all of them are processed.
+ */
+
+void *taskboard_write(void *void_ptr)
+{
+	struct taskboard *ptr = (struct taskboard *)void_ptr;
+
+	for (vamp_t i = 0; i < ptr->size; i++) {
+		while (sem_wait(&(ptr->completed)) != 0)
+			continue;
+		taskboard_cleanup(ptr);
+	}
+	return NULL;
+}
+
 void taskboard_print_results(struct taskboard *ptr)
 {
+	char count_str[VAMP_STR_SIZE];
 #if defined COUNT_RESULTS || defined DUMP_RESULTS
-	fprintf(stderr, "Found: %llu valid fang pair(s).\n", ptr->common_count);
+	fprintf(stderr, "Found: %s valid fang pair(s).\n", vtostr(ptr->common_count, count_str));
 #else
-	fprintf(stderr, "Found: %llu vampire number(s).\n", ptr->common_count);
+	fprintf(stderr, "Found: %s vampire number(s).\n", vtostr(ptr->common_count, count_str));
 #endif
 	hash_print(ptr->checksum);
 }
 
-// taskboard_progress requires mutex lock
+// taskboard_progress is only called by taskboard_write
 void taskboard_progress(struct taskboard *ptr)
 {
-	if (ptr->options.display_progress) {
-		fprintf(stderr, "%llu, %llu", ptr->tasks[ptr->done]->lmin, ptr->tasks[ptr->done]->lmax);
-		fprintf(stderr, "  %llu/%llu\n", ptr->done + 1, ptr->size);
+	char str_a[VAMP_STR_SIZE];
+	char str_b[VAMP_STR_SIZE];
+	if (ptr->options.display_progress && ptr->options.fang_tasks) {
+		fprintf(stderr, "%lu, %lu", ptr->tasks[ptr->done]->fmin, ptr->tasks[ptr->done]->fmax);
+		fprintf(stderr, "  %s/%s\n", vtostr(ptr->done + 1, str_a), vtostr(ptr->size, str_b));
+	} else if (ptr->options.display_progress) {
+		fprintf(stderr, "%s, %s", vtostr(ptr->tasks[ptr->done]->lmin, str_a), vtostr(ptr->tasks[ptr->done]->lmax, str_b));
+		fprintf(stderr, "  %s/%s\n", vtostr(ptr->done + 1, str_a), vtostr(ptr->size, str_b));
 	}
 }
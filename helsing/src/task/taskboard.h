@@ -6,29 +6,51 @@
 #ifndef HELSING_TASKBOARD_H
 #define HELSING_TASKBOARD_H
 
+#include <semaphore.h>
+#include <stdatomic.h>
+
 #include "configuration.h"
 #include "configuration_adv.h"
 #include "task.h"
 #include "options.h"
 #include "hash.h"
+#include "llnode.h"
+
+#define TASKBOARD_LINE 64 // The size of a cache line
+
+/*
+ * taskboard:
+ *
+ * The fields that change while a band runs are on their own cache lines, so
+ * that the worker threads and taskboard_write don't invalidate each other's
+ * lines: todo is taken by the worker threads, completed is posted by them,
+ * and done & common_count are only used by taskboard_write.
+ */
 
 struct taskboard
 {
 	struct options_t options;
 	struct task **tasks;
 	vamp_t size; // The size of the tasks array
-	vamp_t todo; // First task that hasn't been accepted.
-	vamp_t done; // Last task that's completed, but isn't yet processed. (print, hash, checksum...)
 	fang_t fmax;
+	const struct kernel *kernel; // The kernel of the current band, see kernel_band
+
+	_Alignas(TASKBOARD_LINE) atomic_size_t todo; // First task that hasn't been accepted.
+
+	_Alignas(TASKBOARD_LINE) sem_t completed; // Posted once per completed task, see taskboard_write.
+
+	_Alignas(TASKBOARD_LINE) vamp_t done; // Last task that's completed, but isn't yet processed. (print, hash, checksum...)
 	vamp_t common_count;
 	struct hash *checksum;
+	struct llnode *raw; // Results of the fang tasks, see taskboard_merge.
 };
 
 void taskboard_new(struct taskboard **ptr, struct options_t options);
 void taskboard_free(struct taskboard *ptr);
 void taskboard_set(struct taskboard *ptr, vamp_t lmin, vamp_t lmax);
 struct task *taskboard_get_task(struct taskboard *ptr);
-void taskboard_cleanup(struct taskboard *ptr);
+void taskboard_complete(struct taskboard *ptr, struct task *task, struct vargs *vamp_args);
+void *taskboard_write(void *void_ptr);
 void taskboard_print_results(struct taskboard *ptr);
 void taskboard_progress(struct taskboard *ptr);
 #endif /* HELSING_TASKBOARD_H */
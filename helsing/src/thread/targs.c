@@ -4,7 +4,6 @@
  */
 
 #include <stdlib.h>
-#include <pthread.h>
 
 #include "configuration.h"
 #include "cache.h"
@@ -21,8 +20,6 @@
 
 void targs_new(
 	struct targs **ptr,
-	pthread_mutex_t *read,
-	pthread_mutex_t *write,
 	struct taskboard *progress,
 	struct cache *digptr)
 {
@@ -35,8 +32,6 @@ void targs_new(
 	if (new == NULL)
 		abort();
 
-	new->read = read;
-	new->write = write;
 	new->progress = progress;
 	new->runtime = 0.0;
 	new->digptr = digptr;
@@ -54,34 +49,17 @@ void *thread_function(void *void_args)
 	struct targs *args = (struct targs *)void_args;
 	thread_timer_start(args);
 	struct vargs *vamp_args = NULL;
-	vargs_new(&(vamp_args), args->digptr);
+	vargs_new(&(vamp_args), args->digptr, args->progress->kernel, args->progress->options.fang_tasks);
 	struct task *current = NULL;
 
 	do {
-		current = NULL;
-// Critical section start
-		pthread_mutex_lock(args->read);
-
 		current = taskboard_get_task(args->progress);
-
-		pthread_mutex_unlock(args->read);
-// Critical section end
-
 		if (current != NULL) {
-			vampire(current->lmin, current->lmax, vamp_args, args->progress->fmax);
-
-// Critical section start
-			pthread_mutex_lock(args->write);
-
-			task_copy_vargs(current, vamp_args);
+			vampire(current->lmin, current->lmax, vamp_args, current->fmin, current->fmax);
 #if MEASURE_RUNTIME
-			args->total += current->count;
+			args->total += vamp_args->local_count;
 #endif
-			taskboard_cleanup(args->progress);
-
-			pthread_mutex_unlock(args->write);
-
-// Critical section end
+			taskboard_complete(args->progress, current, vamp_args);
 			vargs_reset(vamp_args);
 		}
 	} while (current != NULL);
@@ -6,8 +6,6 @@
 #ifndef HELSING_TARGS_H
 #define HELSING_TARGS_H
 
-#include <pthread.h>
-
 #include "configuration.h"
 #include "configuration_adv.h"
 #include "taskboard.h"
@@ -19,8 +17,6 @@
 
 struct targs
 {
-	pthread_mutex_t *read;
-	pthread_mutex_t *write;
 	struct taskboard *progress;
 	double	runtime;
 	struct cache *digptr;
@@ -33,8 +29,6 @@ struct targs
 
 void targs_new(
 	struct targs **ptr,
-	pthread_mutex_t *read,
-	pthread_mutex_t *write,
 	struct taskboard *progress,
 	struct cache *digptr);
 
@@ -4,7 +4,6 @@
  */
 
 #include <stdlib.h>
-#include <pthread.h>
 #include <stdio.h>
 
 #include "configuration.h"
@@ -13,6 +12,8 @@
 #include "cache.h"
 #include "targs.h"
 #include "targs_handle.h"
+#include "kernel.h"
+#include "helper.h"
 
 #if SANITY_CHECK
 #include <assert.h>
@@ -32,20 +33,25 @@ void targs_handle_new(struct targs_handle **ptr, struct options_t options, vamp_
 	new->options = options;
 	new->progress = progress;
 	new->digptr = NULL;
-	cache_new(&(new->digptr), min, max);
+
+	/*
+	 * The CACHE only covers the bands where it can't overflow, the ones
+	 * above it use 'nocache', see kernel_band.
+	 */
+	vamp_t cache_max = max;
+	while (cache_max >= min && cache_max > 0 && cache_ovf_chk(cache_max))
+		cache_max = pow_v(length(cache_max) - 1) - 1;
+
+	if (options.kernel->cache && cache_max >= min && cache_max > 0)
+		cache_new(&(new->digptr), min, cache_max, options.kernel->pack, (options.kernel->run4 != NULL) ? 4 : 3);
 
 	new->targs = malloc(sizeof(struct targs *) * new->options.threads);
 	if (new->targs == NULL)
 		abort();
 
-	new->read = malloc(sizeof(pthread_mutex_t));
-	pthread_mutex_init(new->read, NULL);
-	new->write = malloc(sizeof(pthread_mutex_t));
-	pthread_mutex_init(new->write, NULL);
-
 	for (thread_t thread = 0; thread < new->options.threads; thread++) {
 		new->targs[thread] = NULL;
-		targs_new(&(new->targs[thread]), new->read, new->write, new->progress, new->digptr);
+		targs_new(&(new->targs[thread]), new->progress, new->digptr);
 	}
 	*ptr = new;
 }
@@ -55,10 +61,6 @@ void targs_handle_free(struct targs_handle *ptr)
 	if (ptr == NULL)
 		return;
 
-	pthread_mutex_destroy(ptr->read);
-	free(ptr->read);
-	pthread_mutex_destroy(ptr->write);
-	free(ptr->write);
 	cache_free(ptr->digptr);
 
 	for (thread_t thread = 0; thread < ptr->options.threads; thread++)
@@ -74,7 +76,8 @@ void targs_handle_print(struct targs_handle *ptr)
 	double total_time = 0.0;
 	fprintf(stderr, "Thread  Runtime Count\n");
 	for (thread_t thread = 0; thread < ptr->options.threads; thread++) {
-		fprintf(stderr, "%u\t%.2lfs\t%llu\n", thread, ptr->targs[thread]->runtime, ptr->targs[thread]->total);
+		char total_str[VAMP_STR_SIZE];
+		fprintf(stderr, "%u\t%.2lfs\t%s\n", thread, ptr->targs[thread]->runtime, vtostr(ptr->targs[thread]->total, total_str));
 		total_time += ptr->targs[thread]->runtime;
 	}
 	fprintf(stderr, "\nFang search took: %.2lf s, average: %.2lf s\n", total_time, total_time / ptr->options.threads);
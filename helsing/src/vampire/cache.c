@@ -10,6 +10,8 @@
 #if CACHE
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
 #include <math.h>
 #include "helper.h"
 #include "cache.h"
@@ -23,6 +25,9 @@
 
 #define DIGBASE(bits) ((vamp_t) pow(2.0, ((double)(bits))/(double)(BASE - 1)))
 
+#define CPU_CACHE_LEVELS 3
+#define CPU_CACHE_SYSFS "/sys/devices/system/cpu/cpu0/cache"
+
 digits_t set_dig(fang_t number)
 {
 	digits_t ret = 0;
@@ -36,38 +41,215 @@ digits_t set_dig(fang_t number)
 	return ret;
 }
 
-void cache_new(struct cache **ptr, vamp_t min, vamp_t max)
+/*
+ * cpu_cache_sizes:
+ *
+ * Reads the size in bytes of the data (or unified) cpu cache of each level
+ * from sysfs. The levels that can't be read are left 0.
+ */
+
+static void cpu_cache_sizes(vamp_t sizes[CPU_CACHE_LEVELS + 1])
+{
+	for (int level = 0; level <= CPU_CACHE_LEVELS; level++)
+		sizes[level] = 0;
+
+	for (int index = 0; ; index++) {
+		char path[64];
+		int level = 0;
+		char type[16] = "";
+		unsigned long long size = 0;
+		char unit = '\0';
+		FILE *fp;
+
+		snprintf(path, sizeof(path), CPU_CACHE_SYSFS "/index%d/level", index);
+		fp = fopen(path, "r");
+		if (fp == NULL)
+			break;
+		if (fscanf(fp, "%d", &level) != 1)
+			level = 0;
+		fclose(fp);
+
+		snprintf(path, sizeof(path), CPU_CACHE_SYSFS "/index%d/type", index);
+		fp = fopen(path, "r");
+		if (fp == NULL)
+			break;
+		if (fscanf(fp, "%15s", type) != 1)
+			type[0] = '\0';
+		fclose(fp);
+
+		snprintf(path, sizeof(path), CPU_CACHE_SYSFS "/index%d/size", index);
+		fp = fopen(path, "r");
+		if (fp == NULL)
+			break;
+		if (fscanf(fp, "%llu%c", &size, &unit) < 1)
+			size = 0;
+		fclose(fp);
+
+		if (unit == 'K')
+			size <<= 10;
+		else if (unit == 'M')
+			size <<= 20;
+		else if (unit == 'G')
+			size <<= 30;
+
+		if (level > 0 && level <= CPU_CACHE_LEVELS && strcmp(type, "Instruction") != 0)
+			sizes[level] = size;
+	}
+}
+
+/*
+ * cache_part:
+ *
+ * The length of the largest part of a product of length digits, when split
+ * in parts parts. dig[] needs BASE^cache_part() elements.
+ */
+
+static length_t cache_part(length_t length, length_t parts)
+{
+	length_t part_A = partition(length, parts);
+	length_t part_B = 0;
+	if (length > (parts - 1) * part_A)
+		part_B = length - (parts - 1) * part_A;
+	return (part_A > part_B) ? part_A : part_B;
+}
+
+/*
+ * cache_pack_count:
+ *
+ * The number of unique elements of dig[] for the numbers of up to length
+ * digits, which is the number of multisets of up to length nonzero digits:
+ * (length + BASE - 1)! / (length! * (BASE - 1)!). Stops counting at
+ * DIGPACK_MAX + 1.
+ */
+
+static vamp_t cache_pack_count(length_t length)
+{
+	vamp_t ret = 1;
+	for (length_t i = 1; i <= length && ret <= DIGPACK_MAX; i++)
+		ret = ret * (BASE - 1 + i) / i;
+	return ret;
+}
+
+/*
+ * cache_pack:
+ *
+ * Stores each unique element of dig[] once in lut[], and its index in
+ * pack[], so that dig[d] == lut[pack[d]]. pack[] is a fraction of the size of
+ * dig[], and lut[] is small enough to stay in L1/L2. The indices are found
+ * with an open addressing hash table, which is freed afterwards.
+ */
+
+static void cache_pack(struct cache *ptr, vamp_t count)
+{
+	fang_t table_size = 1;
+	while (table_size < 2 * count)
+		table_size <<= 1;
+
+	uint32_t *table = calloc(table_size, sizeof(uint32_t)); // index + 1
+	ptr->lut = malloc(sizeof(digits_t) * count);
+	ptr->pack = malloc(sizeof(digpack_t) * ptr->size);
+	if (table == NULL || ptr->lut == NULL || ptr->pack == NULL)
+		abort();
+
+	uint32_t unique = 0;
+	for (fang_t d = 0; d < ptr->size; d++) {
+		digits_t dig = set_dig(d);
+		fang_t h = ((uint64_t)dig * 0x9E3779B97F4A7C15ULL) >> 32;
+		for (h &= table_size - 1; table[h] != 0; h = (h + 1) & (table_size - 1))
+			if (ptr->lut[table[h] - 1] == dig)
+				break;
+
+		if (table[h] == 0) {
+#if SANITY_CHECK
+			assert(unique < count);
+#endif
+			ptr->lut[unique] = dig;
+			table[h] = ++unique;
+		}
+		ptr->pack[d] = table[h] - 1;
+	}
+	free(table);
+}
+
+/*
+ * cache_new:
+ *
+ * The kernels split the product in 3 or 4 parts, see partition(). More parts
+ * make dig[] smaller, but cost one more load & carry per multiplicand, and a
+ * smaller A makes the carries less predictable. We only pick 4 parts for the
+ * lengths of product where the dig[] of 3 parts doesn't fit in the largest
+ * level of cpu cache, and store the choice in parts[]. Those bands run with
+ * kernel->run4. max_parts is 4 for the kernels that have run4, otherwise 3.
+ *
+ * We don't pick the parts per level of cpu cache, and never use 2 parts:
+ * only the gap between the CACHE of 3 parts and the largest level is large
+ * enough to pay for the extra carries, see configuration.h.
+ *
+ * If pack is set we allocate pack[] & lut[] instead of dig[], see
+ * cache_pack(). If the unique elements don't fit in a digpack_t, or some band
+ * uses 4 parts (run4 only reads dig[]), we allocate dig[] anyway, and the
+ * kernel falls back to it.
+ */
+
+void cache_new(struct cache **ptr, vamp_t min, vamp_t max, bool pack, length_t max_parts)
 {
 #if SANITY_CHECK
 	assert(ptr != NULL);
 	assert (*ptr == NULL);
+	assert(max_parts >= 3 && max_parts <= 4);
 #endif
 
 	struct cache *new = malloc(sizeof(struct cache));
 	if (new == NULL)
 		abort();
 
+	vamp_t sizes[CPU_CACHE_LEVELS + 1];
+	cpu_cache_sizes(sizes);
+
+	vamp_t cpu_cache = 0; // The largest level, 0 if unknown
+	for (int level = 1; level <= CPU_CACHE_LEVELS; level++)
+		if (sizes[level] > cpu_cache)
+			cpu_cache = sizes[level];
+
+	vamp_t element = sizeof(digits_t);
+	if (pack)
+		element = sizeof(digpack_t);
+
 	length_t cs = 0;
-	length_t i = length(min);
-	do {
-		length_t part_A = partition3(i);
-		length_t part_B = 0;
-		if (i / 2 > part_A)
-			part_B = i - 2 * part_A;
-
-		if (part_A > cs)
-			cs = part_A;
-		if (part_B > cs)
-			cs = part_B;
-	} while (i < length(max));
+	bool four = false;
+	for (length_t i = 0; i < sizeof(new->parts) / sizeof(new->parts[0]); i++)
+		new->parts[i] = 3;
+
+	for (length_t i = length(min); i <= length(max); i++) {
+		length_t part = cache_part(i, 3);
+		if (cpu_cache > 0 && pow_v(part) * element > cpu_cache) {
+			for (length_t parts = 4; parts <= max_parts; parts++) {
+				if (cache_part(i, parts) < part) {
+					part = cache_part(i, parts);
+					new->parts[i] = parts;
+					four = true;
+				}
+			}
+		}
+		if (part > cs)
+			cs = part;
+	}
 	new->size = pow_v(cs);
 
-	new->dig = malloc(sizeof(digits_t) * new->size);
-	if (new->dig == NULL)
-		abort();
+	new->dig = NULL;
+	new->pack = NULL;
+	new->lut = NULL;
+	if (pack && !four && cache_pack_count(cs) <= DIGPACK_MAX) {
+		cache_pack(new, cache_pack_count(cs));
+	} else {
+		new->dig = malloc(sizeof(digits_t) * new->size);
+		if (new->dig == NULL)
+			abort();
+
+		for (fang_t d = 0; d < new->size; d++)
+			new->dig[d] = set_dig(d);
+	}
 
-	for (fang_t d = 0; d < new->size; d++)
-		new->dig[d] = set_dig(d);
 	*ptr = new;
 }
 
@@ -77,9 +259,23 @@ void cache_free(struct cache *ptr)
 		return;
 
 	free(ptr->dig);
+	free(ptr->pack);
+	free(ptr->lut);
 	free(ptr);
 }
 
+/*
+ * The #parts of the products of length(max), see cache_new.
+ */
+
+length_t cache_parts(struct cache *ptr, vamp_t max)
+{
+	if (ptr == NULL)
+		return 3;
+
+	return ptr->parts[length(max)];
+}
+
 /*
  * Checks if the number can cause overflow.
  */
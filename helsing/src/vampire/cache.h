@@ -9,16 +9,31 @@
 #include "configuration.h"
 #include "configuration_adv.h"
 #include <stdbool.h>
+#include <limits.h>
+
+/*
+ * digpack_t:
+ *
+ * The index of an element of dig[] in lut[], for the kernels that use the
+ * packed CACHE. See cache_new.
+ */
+
+typedef uint16_t digpack_t;
+#define DIGPACK_MAX ((vamp_t)UINT16_MAX + 1)
 
 #if CACHE
 struct cache
 {
-	digits_t *dig;
+	digits_t *dig; // Not allocated if pack is.
+	digpack_t *pack; // Only allocated for the kernels that need it.
+	digits_t *lut; // The unique elements of dig[], if pack is allocated.
 	fang_t size;
+	length_t parts[sizeof(vamp_t) * CHAR_BIT + 1]; // parts[length(max)], see cache_new
 };
 digits_t set_dig(fang_t number);
-void cache_new(struct cache **ptr, vamp_t min, vamp_t max);
+void cache_new(struct cache **ptr, vamp_t min, vamp_t max, bool pack, length_t max_parts);
 void cache_free(struct cache *ptr);
+length_t cache_parts(struct cache *ptr, vamp_t max);
 bool cache_ovf_chk(vamp_t max);
 #else /* !CACHE */
 struct cache
@@ -31,12 +46,20 @@ static inline digits_t set_dig(__attribute__((unused)) fang_t number)
 static inline void cache_new(
 	__attribute__((unused)) struct cache **ptr,
 	__attribute__((unused)) vamp_t min,
-	__attribute__((unused)) vamp_t max)
+	__attribute__((unused)) vamp_t max,
+	__attribute__((unused)) bool pack,
+	__attribute__((unused)) length_t max_parts)
 {
 }
 static inline void cache_free(__attribute__((unused)) struct cache *ptr)
 {
 }
+static inline length_t cache_parts(
+	__attribute__((unused)) struct cache *ptr,
+	__attribute__((unused)) vamp_t max)
+{
+	return 3;
+}
 static inline bool cache_ovf_chk(__attribute__((unused)) vamp_t max)
 {
 	return false;
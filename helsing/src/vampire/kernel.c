@@ -0,0 +1,454 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/*
+ * Copyright (c) 2012 Jens Kruse Andersen
+ * Copyright (c) 2021-2022 Pierro Zachareas
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "configuration.h"
+#include "configuration_adv.h"
+#include "llnode.h"
+#include "vargs.h"
+#include "kernel.h"
+
+#if KERNEL_X86 && USE_PDEP
+#include <immintrin.h>
+#endif
+
+/*
+ * The kernels in order of preference. kernel_best() picks the first one
+ * that the cpu supports. The ones after scalar are only used if selected.
+ */
+
+static bool always()
+{
+	return true;
+}
+
+#if CACHE && KERNEL_X86 && !USE_PDEP
+static bool has_avx2()
+{
+	return __builtin_cpu_supports("avx2");
+}
+
+static bool has_avx512()
+{
+	return __builtin_cpu_supports("avx512f");
+}
+#endif
+
+#if CACHE && KERNEL_X86 && USE_PDEP
+static bool has_bmi2()
+{
+	return __builtin_cpu_supports("bmi2");
+}
+#endif
+
+static const struct kernel kernels[] = {
+#if CACHE && KERNEL_X86 && !USE_PDEP
+	{"avx512", true, false, has_avx512, kernel_avx512, kernel_avx512_32, NULL},
+	{"avx2", true, false, has_avx2, kernel_avx2, kernel_avx2_32, NULL},
+#endif
+#if CACHE && KERNEL_X86 && USE_PDEP
+	{"pdep", true, false, has_bmi2, kernel_pdep, NULL, kernel_scalar4},
+#endif
+#if CACHE
+	{"scalar", true, false, always, kernel_scalar, NULL, kernel_scalar4},
+	{"packed", true, true, always, kernel_packed, NULL, kernel_scalar4},
+#endif
+	{"nocache", false, false, always, kernel_nocache, NULL, NULL},
+};
+
+#define KERNELS_SIZE (sizeof(kernels) / sizeof(kernels[0]))
+
+const struct kernel *kernel_best()
+{
+	for (size_t i = 0; i < KERNELS_SIZE; i++)
+		if (kernels[i].supported())
+			return &(kernels[i]);
+
+	return NULL;
+}
+
+const struct kernel *kernel_get(const char *name)
+{
+	for (size_t i = 0; i < KERNELS_SIZE; i++)
+		if (strcmp(kernels[i].name, name) == 0 && kernels[i].supported())
+			return &(kernels[i]);
+
+	return NULL;
+}
+
+/*
+ * kernel_band:
+ *
+ * The kernel for a band of products up to max. If the CACHE might produce
+ * false positives there, see cache_ovf_chk, we fall back to 'nocache'.
+ */
+
+const struct kernel *kernel_band(const struct kernel *kernel, vamp_t max)
+{
+	if (kernel->cache && cache_ovf_chk(max))
+		return kernel_get("nocache");
+
+	return kernel;
+}
+
+void kernel_print_names()
+{
+	for (size_t i = 0; i < KERNELS_SIZE; i++)
+		if (kernels[i].supported())
+			printf(" %s", kernels[i].name);
+	printf("\n");
+}
+
+#if BASE <= 64
+/*
+ * hist_t:
+ *
+ * A histogram of digits, with one byte per digit. With the vector extensions
+ * of gcc & clang, adding & comparing histograms are a few SSE/AVX (or NEON)
+ * instructions, instead of a loop over BASE elements. The counts wrap around
+ * at 256, but they never differ by that much.
+ */
+
+#define HIST_SIZE (BASE <= 16 ? 16 : (BASE <= 32 ? 32 : 64))
+typedef uint8_t hist_t __attribute__((vector_size(HIST_SIZE)));
+
+// The most digits per lookup, that keep each table within 256KB.
+#define HIST_ENTRIES (256 * 1024 / HIST_SIZE)
+#define HIST_DIGITS \
+	(BASE * BASE * BASE * BASE <= HIST_ENTRIES ? 4 : \
+	(BASE * BASE * BASE <= HIST_ENTRIES ? 3 : 2))
+#define HIST_CHUNK \
+	(HIST_DIGITS == 4 ? BASE * BASE * BASE * BASE : \
+	(HIST_DIGITS == 3 ? BASE * BASE * BASE : BASE * BASE))
+
+/*
+ * hist_full[x] is the histogram of the HIST_DIGITS digits of x, hist_top[x]
+ * the same without the leading zeros. They are set once, by the first
+ * kernel_nocache.
+ */
+
+static hist_t hist_full[HIST_CHUNK];
+static hist_t hist_top[HIST_CHUNK];
+static pthread_once_t hist_once = PTHREAD_ONCE_INIT;
+
+static void hist_init()
+{
+	for (fang_t x = 0; x < HIST_CHUNK; x++) {
+		hist_t full = {0};
+		hist_t top = {0};
+		fang_t tmp = x;
+		for (length_t i = 0; i < HIST_DIGITS; i++) {
+			full[tmp % BASE] += 1;
+			if (tmp > 0)
+				top[tmp % BASE] += 1;
+			tmp /= BASE;
+		}
+		hist_full[x] = full;
+		hist_top[x] = top;
+	}
+}
+
+// Adds the histogram of x to h. We pass hist_t by pointer, see -Wpsabi.
+static inline void hist_add(hist_t *h, vamp_t x)
+{
+	for (; x >= HIST_CHUNK; x /= HIST_CHUNK)
+		*h += hist_full[x % HIST_CHUNK];
+	*h += hist_top[x];
+}
+
+/*
+ * kernel_nocache:
+ *
+ * Compares the histogram of the digits of the product with the ones of the
+ * multiplier & the multiplicand, see hist_t. The digits of the product and
+ * of the multiplicand are two independent chains of divisions by a constant,
+ * which the compiler turns into multiplications, and the cpu overlaps them.
+ */
+
+void kernel_nocache(struct kargs *ka, struct vargs *args, struct llnode **ll)
+{
+	fang_t multiplier = ka->multiplier;
+	fang_t multiplicand = ka->multiplicand;
+	fang_t multiplicand_max = ka->multiplicand_max;
+	vamp_t product = ka->product;
+	vamp_t product_iterator = ka->product_iterator;
+
+	pthread_once(&hist_once, hist_init);
+	hist_t mult_hist = {0};
+	hist_add(&mult_hist, multiplier);
+
+	for (; multiplicand <= multiplicand_max; multiplicand += BASE - 1) {
+		hist_t fangs = mult_hist;
+		hist_t prod = {0};
+		hist_add(&fangs, multiplicand);
+		hist_add(&prod, product);
+		if (memcmp(&fangs, &prod, sizeof(hist_t)) == 0)
+			if (ka->mult_zero || notrailingzero(multiplicand))
+				kernel_hit(args, ll, product, multiplier, multiplicand);
+
+		product += product_iterator;
+	}
+}
+#else /* BASE > 64 */
+void kernel_nocache(struct kargs *ka, struct vargs *args, struct llnode **ll)
+{
+	fang_t multiplier = ka->multiplier;
+	fang_t multiplicand = ka->multiplicand;
+	fang_t multiplicand_max = ka->multiplicand_max;
+	vamp_t product = ka->product;
+	vamp_t product_iterator = ka->product_iterator;
+
+	length_t mult_array[BASE] = {0};
+	for (fang_t i = multiplier; i > 0; i /= BASE)
+		mult_array[i % BASE] += 1;
+
+	for (; multiplicand <= multiplicand_max; multiplicand += BASE - 1) {
+		uint16_t product_array[BASE] = {0};
+		for (vamp_t p = product; p > 0; p /= BASE)
+			product_array[p % BASE] += 1;
+
+		for (digit_t i = 0; i < BASE; i++)
+			if (product_array[i] < mult_array[i])
+				goto vampire_exit;
+
+		digit_t temp;
+		for (fang_t m = multiplicand; m > 0; m /= BASE) {
+			temp = m % BASE;
+			if (product_array[temp] == 0)
+				goto vampire_exit;
+			else
+				product_array[temp]--;
+		}
+		for (digit_t i = 0; i < (BASE - 1); i++)
+			if (product_array[i] != mult_array[i])
+				goto vampire_exit;
+
+		if (ka->mult_zero || notrailingzero(multiplicand))
+			kernel_hit(args, ll, product, multiplier, multiplicand);
+vampire_exit:
+		product += product_iterator;
+	}
+}
+
+#endif /* BASE <= 64 */
+
+#if CACHE
+
+#if USE_PDEP
+static inline uint64_t get_pdep_mask()
+{
+	uint64_t single_element_mask = 1;
+	single_element_mask <<= (ACTIVE_BITS - 1) / (BASE - 1);
+	single_element_mask -= 1;
+	single_element_mask <<= 1;
+	single_element_mask += 1;
+
+	uint64_t ret = single_element_mask;
+	for (int i = 1; i < BASE - 1; i++) {
+		ret <<= (COMPARISON_BITS / (BASE - 1));
+		ret += single_element_mask;
+	}
+	return ret;
+}
+
+/*
+ * expand:
+ *
+ * Same as _pdep_u64(x, get_pdep_mask()), for cpus without BMI2.
+ * Moves each of the (BASE - 1) bitfields to its own COMPARISON_BITS / (BASE - 1)
+ * bits.
+ */
+
+static inline uint64_t expand(digits_t x)
+{
+	const length_t width = ACTIVE_BITS / (BASE - 1);
+	const uint64_t field_mask = ((uint64_t)1 << width) - 1;
+
+	uint64_t ret = 0;
+	for (digit_t i = 0; i < BASE - 1; i++) {
+		ret |= (x & field_mask) << (i * (COMPARISON_BITS / (BASE - 1)));
+		x >>= width;
+	}
+	return ret;
+}
+#endif /* USE_PDEP */
+
+/*
+ * digsum_t:
+ *
+ * The sums of digits_t that the kernels compare. With USE_PDEP each element
+ * is expanded to 64 bits first, see expand.
+ */
+
+#if USE_PDEP
+typedef uint64_t digsum_t;
+#else
+typedef digits_t digsum_t;
+#endif
+
+static inline digsum_t digsum(digits_t x)
+{
+#if USE_PDEP
+	return expand(x);
+#else
+	return x;
+#endif
+}
+
+/*
+ * kargs_next:
+ *
+ * Moves to the next multiplicand, with the product in 3 parts. The kernels
+ * work on a local copy of kargs, and only differ in how they compare the
+ * digits.
+ */
+
+static inline void kargs_next(struct kargs *k)
+{
+	k->multiplicand += BASE - 1;
+	k->product += k->product_iterator;
+	k->e0 += BASE - 1;
+	if (k->e0 >= k->power_a) {
+		k->e0 -= k->power_a;
+		k->e1 += 1;
+	}
+	k->de0 += k->step0;
+	if (k->de0 >= k->power_a) {
+		k->de0 -= k->power_a;
+		k->de1 += 1;
+	}
+	k->de1 += k->step1;
+	if (k->de1 >= k->power_a) {
+		k->de1 -= k->power_a;
+		k->de2 += 1;
+	}
+}
+
+/*
+ * kargs_next4:
+ *
+ * Same as kargs_next, with the product in 4 parts (de0, de1, de2 & de3)
+ * and the multiplicand & the product iterator in 3, see cache_new.
+ */
+
+static inline void kargs_next4(struct kargs *k)
+{
+	k->multiplicand += BASE - 1;
+	k->product += k->product_iterator;
+	k->e0 += BASE - 1;
+	if (k->e0 >= k->power_a) {
+		k->e0 -= k->power_a;
+		k->e1 += 1;
+		if (k->e1 >= k->power_a) {
+			k->e1 -= k->power_a;
+			k->e2 += 1;
+		}
+	}
+	k->de0 += k->step0;
+	if (k->de0 >= k->power_a) {
+		k->de0 -= k->power_a;
+		k->de1 += 1;
+	}
+	k->de1 += k->step1;
+	if (k->de1 >= k->power_a) {
+		k->de1 -= k->power_a;
+		k->de2 += 1;
+	}
+	k->de2 += k->step2;
+	if (k->de2 >= k->power_a) {
+		k->de2 -= k->power_a;
+		k->de3 += 1;
+	}
+}
+
+void kernel_scalar(struct kargs *ka, struct vargs *args, struct llnode **ll)
+{
+	struct kargs k = *ka;
+	const digits_t *dig = k.dig;
+	const digsum_t digd = digsum(k.digd);
+
+	for (; k.multiplicand <= k.multiplicand_max; kargs_next(&k))
+		if (digd + digsum(dig[k.e0]) + digsum(dig[k.e1]) ==
+		    digsum(dig[k.de0]) + digsum(dig[k.de1]) + digsum(dig[k.de2]))
+			if (k.mult_zero || notrailingzero(k.multiplicand))
+				kernel_hit(args, ll, k.product, k.multiplier, k.multiplicand);
+}
+
+/*
+ * kernel_scalar4:
+ *
+ * Same as kernel_scalar, with the product in 4 parts, see kargs_next4.
+ */
+
+void kernel_scalar4(struct kargs *ka, struct vargs *args, struct llnode **ll)
+{
+	struct kargs k = *ka;
+	const digits_t *dig = k.dig;
+	const digsum_t digd = digsum(k.digd);
+
+	for (; k.multiplicand <= k.multiplicand_max; kargs_next4(&k))
+		if (digd + digsum(dig[k.e0]) + digsum(dig[k.e1]) + digsum(dig[k.e2]) ==
+		    digsum(dig[k.de0]) + digsum(dig[k.de1]) + digsum(dig[k.de2]) + digsum(dig[k.de3]))
+			if (k.mult_zero || notrailingzero(k.multiplicand))
+				kernel_hit(args, ll, k.product, k.multiplier, k.multiplicand);
+}
+
+/*
+ * kernel_packed:
+ *
+ * Same as kernel_scalar, with the packed CACHE: dig[x] is lut[pack[x]],
+ * see cache_pack. pack[] is 1/4 of the size of dig[] (1/2 with USE_PDEP),
+ * while lut[] stays in L1/L2. If cache_new() couldn't pack the CACHE we fall
+ * back to kernel_scalar.
+ */
+
+void kernel_packed(struct kargs *ka, struct vargs *args, struct llnode **ll)
+{
+	if (ka->pack == NULL) {
+		kernel_scalar(ka, args, ll);
+		return;
+	}
+
+	struct kargs k = *ka;
+	const digpack_t *pack = k.pack;
+	const digits_t *lut = k.lut;
+	const digsum_t digd = digsum(k.digd);
+
+	for (; k.multiplicand <= k.multiplicand_max; kargs_next(&k))
+		if (digd + digsum(lut[pack[k.e0]]) + digsum(lut[pack[k.e1]]) ==
+		    digsum(lut[pack[k.de0]]) + digsum(lut[pack[k.de1]]) + digsum(lut[pack[k.de2]]))
+			if (k.mult_zero || notrailingzero(k.multiplicand))
+				kernel_hit(args, ll, k.product, k.multiplier, k.multiplicand);
+}
+
+#if KERNEL_X86 && USE_PDEP
+__attribute__((target("bmi2")))
+void kernel_pdep(struct kargs *ka, struct vargs *args, struct llnode **ll)
+{
+	struct kargs k = *ka;
+	const digits_t *dig = k.dig;
+	const uint64_t pdep_mask = get_pdep_mask();
+	const uint64_t digd = _pdep_u64(k.digd, pdep_mask);
+
+	for (; k.multiplicand <= k.multiplicand_max; kargs_next(&k)) {
+		uint64_t a = digd;
+		a += _pdep_u64(dig[k.e0], pdep_mask);
+		a += _pdep_u64(dig[k.e1], pdep_mask);
+		uint64_t b = 0;
+		b += _pdep_u64(dig[k.de0], pdep_mask);
+		b += _pdep_u64(dig[k.de1], pdep_mask);
+		b += _pdep_u64(dig[k.de2], pdep_mask);
+		if (a == b)
+			if (k.mult_zero || notrailingzero(k.multiplicand))
+				kernel_hit(args, ll, k.product, k.multiplier, k.multiplicand);
+	}
+}
+#endif /* KERNEL_X86 && USE_PDEP */
+#endif /* CACHE */
@@ -0,0 +1,122 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/*
+ * Copyright (c) 2012 Jens Kruse Andersen
+ * Copyright (c) 2021-2022 Pierro Zachareas
+ */
+
+#ifndef HELSING_KERNEL_H
+#define HELSING_KERNEL_H
+
+#include <stdbool.h>
+
+#include "configuration.h"
+#include "configuration_adv.h"
+#include "llnode.h"
+#include "vargs.h"
+
+/*
+ * Kernels that need a specific instruction set are compiled side by side
+ * with function target attributes, and picked at runtime with cpuid.
+ */
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define KERNEL_X86 true
+#else
+#define KERNEL_X86 false
+#endif
+
+/*
+ * kargs:
+ *
+ * Everything a kernel needs to check the multiplicands of a single
+ * multiplier. The CACHE fields are only set for kernels that use the cache,
+ * and e2, de3 & step2 only for run4.
+ */
+
+struct kargs /* Kernel arguments */
+{
+	fang_t multiplier;
+	fang_t multiplicand;
+	fang_t multiplicand_max;
+	vamp_t product;
+	vamp_t product_iterator;
+	bool mult_zero;
+
+	digits_t *dig;
+	digpack_t *pack;
+	digits_t *lut;
+	fang_t power_a;
+	digits_t digd;
+	fang_t e0;
+	fang_t e1;
+	fang_t e2;
+	fang_t de0;
+	fang_t de1;
+	fang_t de2;
+	fang_t de3;
+	fang_t step0;
+	fang_t step1;
+	fang_t step2;
+};
+
+struct kernel
+{
+	const char *name;
+	bool cache; // Uses the CACHE
+	bool pack; // Uses the packed CACHE, see cache_pack
+	bool (*supported)();
+	void (*run)(struct kargs *ka, struct vargs *args, struct llnode **ll);
+
+	/*
+	 * Same as run, with 32-bit lanes. Only for the bands where the fangs
+	 * fit in 32 bits and power_a <= KERNEL32_POWER_A, see vampire().
+	 */
+	void (*run32)(struct kargs *ka, struct vargs *args, struct llnode **ll);
+
+	/*
+	 * Same as run, with the product in 4 parts. Only for the bands where
+	 * cache_new() picks 4 parts. The vector kernels don't have it, they
+	 * keep 3 parts.
+	 */
+	void (*run4)(struct kargs *ka, struct vargs *args, struct llnode **ll);
+};
+
+#define KERNEL32_POWER_A ((fang_t)1 << 30)
+
+const struct kernel *kernel_best();
+const struct kernel *kernel_get(const char *name);
+const struct kernel *kernel_band(const struct kernel *kernel, vamp_t max);
+void kernel_print_names();
+
+void kernel_nocache(struct kargs *ka, struct vargs *args, struct llnode **ll);
+#if CACHE
+void kernel_scalar(struct kargs *ka, struct vargs *args, struct llnode **ll);
+void kernel_scalar4(struct kargs *ka, struct vargs *args, struct llnode **ll);
+void kernel_packed(struct kargs *ka, struct vargs *args, struct llnode **ll);
+#if KERNEL_X86 && USE_PDEP
+void kernel_pdep(struct kargs *ka, struct vargs *args, struct llnode **ll);
+#endif
+#if KERNEL_X86 && !USE_PDEP
+void kernel_avx2(struct kargs *ka, struct vargs *args, struct llnode **ll);
+void kernel_avx2_32(struct kargs *ka, struct vargs *args, struct llnode **ll);
+void kernel_avx512(struct kargs *ka, struct vargs *args, struct llnode **ll);
+void kernel_avx512_32(struct kargs *ka, struct vargs *args, struct llnode **ll);
+#endif
+#endif /* CACHE */
+
+static inline bool notrailingzero(fang_t x)
+{
+	return ((x % BASE) != 0);
+}
+
+static inline void kernel_hit(
+	struct vargs *args,
+	struct llnode **ll,
+	vamp_t product,
+	fang_t multiplier,
+	fang_t multiplicand)
+{
+	vargs_iterate_local_count(args);
+	vargs_print_results(product, multiplier, multiplicand);
+	arena_add(args->arena, ll, product);
+}
+#endif /* HELSING_KERNEL_H */
@@ -0,0 +1,282 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/*
+ * Copyright (c) 2012 Jens Kruse Andersen
+ * Copyright (c) 2021-2022 Pierro Zachareas
+ */
+
+#include "configuration.h"
+#include "configuration_adv.h"
+#include "kernel.h"
+
+#if CACHE && KERNEL_X86 && !USE_PDEP
+#include <immintrin.h>
+#include "llnode.h"
+#include "vargs.h"
+#endif
+
+#if CACHE && KERNEL_X86 && !USE_PDEP
+
+/*
+ * kernel_avx2:
+ *
+ * Check 4 multiplicands per iteration.
+ *
+ * Lane k holds the indices of multiplicand + k * (BASE - 1) and its product.
+ * Every iteration the lanes move forward by 4 * (BASE - 1) and
+ * 4 * product_iterator, both partitioned the same way as step0 & step1.
+ * The carries stay in vector registers: (x > power_a - 1) is all ones, so
+ * subtracting the mask adds 1 to the next part.
+ *
+ * The remaining (< 4) multiplicands are left to kernel_scalar.
+ */
+
+__attribute__((target("avx2")))
+void kernel_avx2(struct kargs *ka, struct vargs *args, struct llnode **ll)
+{
+	const fang_t power_a = ka->power_a;
+	const fang_t multiplicand_max = ka->multiplicand_max;
+	const vamp_t product_iterator = ka->product_iterator;
+	fang_t multiplicand = ka->multiplicand;
+	vamp_t product = ka->product;
+
+	if (multiplicand + 3 * (BASE - 1) > multiplicand_max)
+		goto out;
+
+	fang_t lane[5][4];
+	for (int k = 0; k < 4; k++) {
+		fang_t m = multiplicand + k * (BASE - 1);
+		vamp_t p = product + k * product_iterator;
+		lane[0][k] = m % power_a;
+		lane[1][k] = m / power_a;
+		lane[2][k] = p % power_a;
+		lane[3][k] = (p / power_a) % power_a;
+		lane[4][k] = (p / power_a) / power_a;
+	}
+	__m256i v_e0 = _mm256_loadu_si256((__m256i *)lane[0]);
+	__m256i v_e1 = _mm256_loadu_si256((__m256i *)lane[1]);
+	__m256i v_de0 = _mm256_loadu_si256((__m256i *)lane[2]);
+	__m256i v_de1 = _mm256_loadu_si256((__m256i *)lane[3]);
+	__m256i v_de2 = _mm256_loadu_si256((__m256i *)lane[4]);
+
+	const fang_t quad_m = 4 * (BASE - 1);
+	const vamp_t quad_p = 4 * product_iterator;
+	const __m256i inc_e0 = _mm256_set1_epi64x(quad_m % power_a);
+	const __m256i inc_e1 = _mm256_set1_epi64x(quad_m / power_a);
+	const __m256i inc_de0 = _mm256_set1_epi64x(quad_p % power_a);
+	const __m256i inc_de1 = _mm256_set1_epi64x((quad_p / power_a) % power_a);
+	const __m256i inc_de2 = _mm256_set1_epi64x((quad_p / power_a) / power_a);
+	const __m256i v_power_a = _mm256_set1_epi64x(power_a);
+	const __m256i v_limit = _mm256_set1_epi64x(power_a - 1);
+#if ELEMENT_BITS == 64
+	const long long *base = (const long long *)(ka->dig);
+	const __m256i v_digd = _mm256_set1_epi64x(ka->digd);
+#else
+	const int *base = (const int *)(ka->dig);
+	const __m128i v_digd = _mm_set1_epi32(ka->digd);
+#endif
+
+	for (; multiplicand + 3 * (BASE - 1) <= multiplicand_max; multiplicand += quad_m) {
+#if ELEMENT_BITS == 64
+		__m256i a = _mm256_add_epi64(v_digd, _mm256_i64gather_epi64(base, v_e0, 8));
+		a = _mm256_add_epi64(a, _mm256_i64gather_epi64(base, v_e1, 8));
+		__m256i b = _mm256_i64gather_epi64(base, v_de0, 8);
+		b = _mm256_add_epi64(b, _mm256_i64gather_epi64(base, v_de1, 8));
+		b = _mm256_add_epi64(b, _mm256_i64gather_epi64(base, v_de2, 8));
+		int hits = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(a, b)));
+#else
+		__m128i a = _mm_add_epi32(v_digd, _mm256_i64gather_epi32(base, v_e0, 4));
+		a = _mm_add_epi32(a, _mm256_i64gather_epi32(base, v_e1, 4));
+		__m128i b = _mm256_i64gather_epi32(base, v_de0, 4);
+		b = _mm_add_epi32(b, _mm256_i64gather_epi32(base, v_de1, 4));
+		b = _mm_add_epi32(b, _mm256_i64gather_epi32(base, v_de2, 4));
+		int hits = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(a, b)));
+#endif
+		for (; hits != 0; hits &= hits - 1) {
+			int k = __builtin_ctz(hits);
+			fang_t lane_multiplicand = multiplicand + k * (BASE - 1);
+			if (ka->mult_zero || notrailingzero(lane_multiplicand))
+				kernel_hit(args, ll, product + k * product_iterator, ka->multiplier, lane_multiplicand);
+		}
+		product += quad_p;
+
+		__m256i carry;
+		v_e0 = _mm256_add_epi64(v_e0, inc_e0);
+		carry = _mm256_cmpgt_epi64(v_e0, v_limit);
+		v_e0 = _mm256_sub_epi64(v_e0, _mm256_and_si256(carry, v_power_a));
+		v_e1 = _mm256_sub_epi64(_mm256_add_epi64(v_e1, inc_e1), carry);
+
+		v_de0 = _mm256_add_epi64(v_de0, inc_de0);
+		carry = _mm256_cmpgt_epi64(v_de0, v_limit);
+		v_de0 = _mm256_sub_epi64(v_de0, _mm256_and_si256(carry, v_power_a));
+		v_de1 = _mm256_sub_epi64(_mm256_add_epi64(v_de1, inc_de1), carry);
+		carry = _mm256_cmpgt_epi64(v_de1, v_limit);
+		v_de1 = _mm256_sub_epi64(v_de1, _mm256_and_si256(carry, v_power_a));
+		v_de2 = _mm256_sub_epi64(_mm256_add_epi64(v_de2, inc_de2), carry);
+	}
+
+	// Lane 0 holds the first multiplicand that hasn't been checked.
+	ka->multiplicand = multiplicand;
+	ka->product = product;
+	ka->e0 = _mm256_extract_epi64(v_e0, 0);
+	ka->e1 = _mm256_extract_epi64(v_e1, 0);
+	ka->de0 = _mm256_extract_epi64(v_de0, 0);
+	ka->de1 = _mm256_extract_epi64(v_de1, 0);
+	ka->de2 = _mm256_extract_epi64(v_de2, 0);
+out:
+	kernel_scalar(ka, args, ll);
+}
+
+#if ELEMENT_BITS == 64
+// The 64-bit elements of 4 lanes with 32-bit indices, see kernel_avx2_32.
+__attribute__((target("avx2")))
+static inline int match4(
+	const long long *base,
+	__m256i v_digd,
+	__m128i e0,
+	__m128i e1,
+	__m128i de0,
+	__m128i de1,
+	__m128i de2)
+{
+	__m256i a = _mm256_add_epi64(v_digd, _mm256_i32gather_epi64(base, e0, 8));
+	a = _mm256_add_epi64(a, _mm256_i32gather_epi64(base, e1, 8));
+	__m256i b = _mm256_i32gather_epi64(base, de0, 8);
+	b = _mm256_add_epi64(b, _mm256_i32gather_epi64(base, de1, 8));
+	b = _mm256_add_epi64(b, _mm256_i32gather_epi64(base, de2, 8));
+	return _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(a, b)));
+}
+#endif
+
+/*
+ * kernel_avx2_32:
+ *
+ * Check 8 multiplicands per iteration.
+ *
+ * Same as kernel_avx2, for bands where the indices (< power_a) fit in 32-bit
+ * lanes, which doubles the lanes of every vector operation. The signed
+ * comparisons need x + inc < 2^31, so power_a must be at most 2^30.
+ *
+ * The remaining (< 8) multiplicands are left to kernel_scalar.
+ */
+
+__attribute__((target("avx2")))
+void kernel_avx2_32(struct kargs *ka, struct vargs *args, struct llnode **ll)
+{
+	const fang_t power_a = ka->power_a;
+	const fang_t multiplicand_max = ka->multiplicand_max;
+	const vamp_t product_iterator = ka->product_iterator;
+	fang_t multiplicand = ka->multiplicand;
+	vamp_t product = ka->product;
+
+	if (multiplicand + 7 * (BASE - 1) > multiplicand_max)
+		goto out;
+
+	// Lane k is lane k - 1 plus one step of kernel_scalar.
+	fang_t e0 = ka->e0;
+	fang_t e1 = ka->e1;
+	fang_t de0 = ka->de0;
+	fang_t de1 = ka->de1;
+	fang_t de2 = ka->de2;
+	uint32_t lane[5][8];
+	for (int k = 0; k < 8; k++) {
+		lane[0][k] = e0;
+		lane[1][k] = e1;
+		lane[2][k] = de0;
+		lane[3][k] = de1;
+		lane[4][k] = de2;
+		e0 += BASE - 1;
+		if (e0 >= power_a) {
+			e0 -= power_a;
+			e1 += 1;
+		}
+		de0 += ka->step0;
+		if (de0 >= power_a) {
+			de0 -= power_a;
+			de1 += 1;
+		}
+		de1 += ka->step1;
+		if (de1 >= power_a) {
+			de1 -= power_a;
+			de2 += 1;
+		}
+	}
+	__m256i v_e0 = _mm256_loadu_si256((__m256i *)lane[0]);
+	__m256i v_e1 = _mm256_loadu_si256((__m256i *)lane[1]);
+	__m256i v_de0 = _mm256_loadu_si256((__m256i *)lane[2]);
+	__m256i v_de1 = _mm256_loadu_si256((__m256i *)lane[3]);
+	__m256i v_de2 = _mm256_loadu_si256((__m256i *)lane[4]);
+
+	const fang_t oct_m = 8 * (BASE - 1);
+	const vamp_t oct_p = 8 * product_iterator;
+	const __m256i inc_e0 = _mm256_set1_epi32(oct_m % power_a);
+	const __m256i inc_e1 = _mm256_set1_epi32(oct_m / power_a);
+	const __m256i inc_de0 = _mm256_set1_epi32(oct_p % power_a);
+	const __m256i inc_de1 = _mm256_set1_epi32((oct_p / power_a) % power_a);
+	const __m256i inc_de2 = _mm256_set1_epi32((oct_p / power_a) / power_a);
+	const __m256i v_power_a = _mm256_set1_epi32(power_a);
+	const __m256i v_limit = _mm256_set1_epi32(power_a - 1);
+#if ELEMENT_BITS == 64
+	const long long *base = (const long long *)(ka->dig);
+	const __m256i v_digd = _mm256_set1_epi64x(ka->digd);
+#else
+	const int *base = (const int *)(ka->dig);
+	const __m256i v_digd = _mm256_set1_epi32(ka->digd);
+#endif
+
+	for (; multiplicand + 7 * (BASE - 1) <= multiplicand_max; multiplicand += oct_m) {
+#if ELEMENT_BITS == 64
+		int hits = match4(base, v_digd,
+			_mm256_castsi256_si128(v_e0),
+			_mm256_castsi256_si128(v_e1),
+			_mm256_castsi256_si128(v_de0),
+			_mm256_castsi256_si128(v_de1),
+			_mm256_castsi256_si128(v_de2));
+		hits |= match4(base, v_digd,
+			_mm256_extracti128_si256(v_e0, 1),
+			_mm256_extracti128_si256(v_e1, 1),
+			_mm256_extracti128_si256(v_de0, 1),
+			_mm256_extracti128_si256(v_de1, 1),
+			_mm256_extracti128_si256(v_de2, 1)) << 4;
+#else
+		__m256i a = _mm256_add_epi32(v_digd, _mm256_i32gather_epi32(base, v_e0, 4));
+		a = _mm256_add_epi32(a, _mm256_i32gather_epi32(base, v_e1, 4));
+		__m256i b = _mm256_i32gather_epi32(base, v_de0, 4);
+		b = _mm256_add_epi32(b, _mm256_i32gather_epi32(base, v_de1, 4));
+		b = _mm256_add_epi32(b, _mm256_i32gather_epi32(base, v_de2, 4));
+		int hits = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b)));
+#endif
+		for (; hits != 0; hits &= hits - 1) {
+			int k = __builtin_ctz(hits);
+			fang_t lane_multiplicand = multiplicand + k * (BASE - 1);
+			if (ka->mult_zero || notrailingzero(lane_multiplicand))
+				kernel_hit(args, ll, product + k * product_iterator, ka->multiplier, lane_multiplicand);
+		}
+		product += oct_p;
+
+		__m256i carry;
+		v_e0 = _mm256_add_epi32(v_e0, inc_e0);
+		carry = _mm256_cmpgt_epi32(v_e0, v_limit);
+		v_e0 = _mm256_sub_epi32(v_e0, _mm256_and_si256(carry, v_power_a));
+		v_e1 = _mm256_sub_epi32(_mm256_add_epi32(v_e1, inc_e1), carry);
+
+		v_de0 = _mm256_add_epi32(v_de0, inc_de0);
+		carry = _mm256_cmpgt_epi32(v_de0, v_limit);
+		v_de0 = _mm256_sub_epi32(v_de0, _mm256_and_si256(carry, v_power_a));
+		v_de1 = _mm256_sub_epi32(_mm256_add_epi32(v_de1, inc_de1), carry);
+		carry = _mm256_cmpgt_epi32(v_de1, v_limit);
+		v_de1 = _mm256_sub_epi32(v_de1, _mm256_and_si256(carry, v_power_a));
+		v_de2 = _mm256_sub_epi32(_mm256_add_epi32(v_de2, inc_de2), carry);
+	}
+
+	// Lane 0 holds the first multiplicand that hasn't been checked.
+	ka->multiplicand = multiplicand;
+	ka->product = product;
+	ka->e0 = (uint32_t)_mm256_extract_epi32(v_e0, 0);
+	ka->e1 = (uint32_t)_mm256_extract_epi32(v_e1, 0);
+	ka->de0 = (uint32_t)_mm256_extract_epi32(v_de0, 0);
+	ka->de1 = (uint32_t)_mm256_extract_epi32(v_de1, 0);
+	ka->de2 = (uint32_t)_mm256_extract_epi32(v_de2, 0);
+out:
+	kernel_scalar(ka, args, ll);
+}
+#endif /* CACHE && KERNEL_X86 && !USE_PDEP */
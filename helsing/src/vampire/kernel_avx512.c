@@ -0,0 +1,322 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/*
+ * Copyright (c) 2012 Jens Kruse Andersen
+ * Copyright (c) 2021-2022 Pierro Zachareas
+ */
+
+#include "configuration.h"
+#include "configuration_adv.h"
+#include "kernel.h"
+
+#if CACHE && KERNEL_X86 && !USE_PDEP
+#include <immintrin.h>
+#include "llnode.h"
+#include "vargs.h"
+#endif
+
+#if CACHE && KERNEL_X86 && !USE_PDEP
+
+/*
+ * flush_hits:
+ *
+ * Process the fang pairs that kernel_avx512 has compressed into the hit
+ * buffer. All of them share the same multiplier, so only the multiplicands
+ * are stored and the products are calculated here, which also works when
+ * vamp_t is wider than the lanes.
+ */
+
+static void flush_hits(struct kargs *ka, struct vargs *args, struct llnode **ll)
+{
+	for (int i = 0; i < args->hits; i++) {
+		if (ka->mult_zero || notrailingzero(args->hit_multiplicand[i])) {
+			vamp_t product = ka->multiplier;
+			product *= args->hit_multiplicand[i];
+			kernel_hit(args, ll, product, ka->multiplier, args->hit_multiplicand[i]);
+		}
+	}
+
+	args->hits = 0;
+}
+
+/*
+ * kernel_avx512:
+ *
+ * Check 8 multiplicands per iteration.
+ *
+ * Works like kernel_avx2, except that the carries are handled with masked
+ * add/sub and there are no branches per lane: vpcompressq writes the
+ * multiplicands of the matching lanes to the hit buffer, which we
+ * process once per multiplier, or whenever it might not fit another 8 hits.
+ *
+ * The remaining (< 8) multiplicands are left to kernel_scalar.
+ */
+
+__attribute__((target("avx512f")))
+void kernel_avx512(struct kargs *ka, struct vargs *args, struct llnode **ll)
+{
+	const fang_t power_a = ka->power_a;
+	const fang_t multiplicand_max = ka->multiplicand_max;
+	const vamp_t product_iterator = ka->product_iterator;
+	const digits_t *dig = ka->dig;
+	fang_t multiplicand = ka->multiplicand;
+
+	if (multiplicand + 7 * (BASE - 1) > multiplicand_max)
+		goto out;
+
+	fang_t lane[6][8];
+	for (int k = 0; k < 8; k++) {
+		fang_t m = multiplicand + k * (BASE - 1);
+		vamp_t p = ka->product + k * product_iterator;
+		lane[0][k] = m % power_a;
+		lane[1][k] = m / power_a;
+		lane[2][k] = p % power_a;
+		lane[3][k] = (p / power_a) % power_a;
+		lane[4][k] = (p / power_a) / power_a;
+		lane[5][k] = m;
+	}
+	__m512i v_e0 = _mm512_loadu_si512(lane[0]);
+	__m512i v_e1 = _mm512_loadu_si512(lane[1]);
+	__m512i v_de0 = _mm512_loadu_si512(lane[2]);
+	__m512i v_de1 = _mm512_loadu_si512(lane[3]);
+	__m512i v_de2 = _mm512_loadu_si512(lane[4]);
+	__m512i v_multiplicand = _mm512_loadu_si512(lane[5]);
+
+	const fang_t oct_m = 8 * (BASE - 1);
+	const vamp_t oct_p = 8 * product_iterator;
+	const __m512i inc_m = _mm512_set1_epi64(oct_m);
+	const __m512i inc_e0 = _mm512_set1_epi64(oct_m % power_a);
+	const __m512i inc_e1 = _mm512_set1_epi64(oct_m / power_a);
+	const __m512i inc_de0 = _mm512_set1_epi64(oct_p % power_a);
+	const __m512i inc_de1 = _mm512_set1_epi64((oct_p / power_a) % power_a);
+	const __m512i inc_de2 = _mm512_set1_epi64((oct_p / power_a) / power_a);
+	const __m512i v_power_a = _mm512_set1_epi64(power_a);
+	const __m512i v_limit = _mm512_set1_epi64(power_a - 1);
+	const __m512i v_one = _mm512_set1_epi64(1);
+#if ELEMENT_BITS == 64
+	const __m512i v_digd = _mm512_set1_epi64(ka->digd);
+#else
+	const __m256i v_digd = _mm256_set1_epi32(ka->digd);
+#endif
+
+	for (; multiplicand + 7 * (BASE - 1) <= multiplicand_max; multiplicand += oct_m) {
+#if ELEMENT_BITS == 64
+		__m512i a = _mm512_add_epi64(v_digd, _mm512_i64gather_epi64(v_e0, dig, 8));
+		a = _mm512_add_epi64(a, _mm512_i64gather_epi64(v_e1, dig, 8));
+		__m512i b = _mm512_i64gather_epi64(v_de0, dig, 8);
+		b = _mm512_add_epi64(b, _mm512_i64gather_epi64(v_de1, dig, 8));
+		b = _mm512_add_epi64(b, _mm512_i64gather_epi64(v_de2, dig, 8));
+		__mmask8 match = _mm512_cmpeq_epi64_mask(a, b);
+#else
+		__m256i a = _mm256_add_epi32(v_digd, _mm512_i64gather_epi32(v_e0, dig, 4));
+		a = _mm256_add_epi32(a, _mm512_i64gather_epi32(v_e1, dig, 4));
+		__m256i b = _mm512_i64gather_epi32(v_de0, dig, 4);
+		b = _mm256_add_epi32(b, _mm512_i64gather_epi32(v_de1, dig, 4));
+		b = _mm256_add_epi32(b, _mm512_i64gather_epi32(v_de2, dig, 4));
+		__mmask8 match = _mm512_cmpeq_epi64_mask(_mm512_cvtepu32_epi64(a), _mm512_cvtepu32_epi64(b));
+#endif
+		_mm512_mask_compressstoreu_epi64(&(args->hit_multiplicand[args->hits]), match, v_multiplicand);
+		args->hits += __builtin_popcount(match);
+		if (args->hits > VARGS_HITS - 8)
+			flush_hits(ka, args, ll);
+
+		v_multiplicand = _mm512_add_epi64(v_multiplicand, inc_m);
+
+		__mmask8 carry;
+		v_e0 = _mm512_add_epi64(v_e0, inc_e0);
+		carry = _mm512_cmpgt_epu64_mask(v_e0, v_limit);
+		v_e0 = _mm512_mask_sub_epi64(v_e0, carry, v_e0, v_power_a);
+		v_e1 = _mm512_add_epi64(v_e1, inc_e1);
+		v_e1 = _mm512_mask_add_epi64(v_e1, carry, v_e1, v_one);
+
+		v_de0 = _mm512_add_epi64(v_de0, inc_de0);
+		carry = _mm512_cmpgt_epu64_mask(v_de0, v_limit);
+		v_de0 = _mm512_mask_sub_epi64(v_de0, carry, v_de0, v_power_a);
+		v_de1 = _mm512_add_epi64(v_de1, inc_de1);
+		v_de1 = _mm512_mask_add_epi64(v_de1, carry, v_de1, v_one);
+		carry = _mm512_cmpgt_epu64_mask(v_de1, v_limit);
+		v_de1 = _mm512_mask_sub_epi64(v_de1, carry, v_de1, v_power_a);
+		v_de2 = _mm512_add_epi64(v_de2, inc_de2);
+		v_de2 = _mm512_mask_add_epi64(v_de2, carry, v_de2, v_one);
+	}
+	flush_hits(ka, args, ll);
+
+	// Lane 0 holds the first multiplicand that hasn't been checked.
+	ka->multiplicand = multiplicand;
+	ka->product = ka->multiplier;
+	ka->product *= multiplicand;
+	ka->e0 = _mm_cvtsi128_si64(_mm512_castsi512_si128(v_e0));
+	ka->e1 = _mm_cvtsi128_si64(_mm512_castsi512_si128(v_e1));
+	ka->de0 = _mm_cvtsi128_si64(_mm512_castsi512_si128(v_de0));
+	ka->de1 = _mm_cvtsi128_si64(_mm512_castsi512_si128(v_de1));
+	ka->de2 = _mm_cvtsi128_si64(_mm512_castsi512_si128(v_de2));
+out:
+	kernel_scalar(ka, args, ll);
+}
+
+#if ELEMENT_BITS == 64
+// The 64-bit elements of 8 lanes with 32-bit indices, see kernel_avx512_32.
+__attribute__((target("avx512f")))
+static inline __mmask8 match8(
+	const digits_t *dig,
+	__m512i v_digd,
+	__m256i e0,
+	__m256i e1,
+	__m256i de0,
+	__m256i de1,
+	__m256i de2)
+{
+	__m512i a = _mm512_add_epi64(v_digd, _mm512_i32gather_epi64(e0, dig, 8));
+	a = _mm512_add_epi64(a, _mm512_i32gather_epi64(e1, dig, 8));
+	__m512i b = _mm512_i32gather_epi64(de0, dig, 8);
+	b = _mm512_add_epi64(b, _mm512_i32gather_epi64(de1, dig, 8));
+	b = _mm512_add_epi64(b, _mm512_i32gather_epi64(de2, dig, 8));
+	return _mm512_cmpeq_epi64_mask(a, b);
+}
+#endif
+
+/*
+ * kernel_avx512_32:
+ *
+ * Check 16 multiplicands per iteration.
+ *
+ * Same as kernel_avx512, for bands where the multiplicands and the indices
+ * (< power_a) fit in 32-bit lanes, which doubles the lanes of every vector
+ * operation. The hits are rare, so instead of keeping the products in
+ * vectors, we compute them when there is one.
+ *
+ * The remaining (< 16) multiplicands are left to kernel_scalar.
+ */
+
+__attribute__((target("avx512f")))
+void kernel_avx512_32(struct kargs *ka, struct vargs *args, struct llnode **ll)
+{
+	const fang_t power_a = ka->power_a;
+	const fang_t multiplicand_max = ka->multiplicand_max;
+	const vamp_t product_iterator = ka->product_iterator;
+	const digits_t *dig = ka->dig;
+	fang_t multiplicand = ka->multiplicand;
+	vamp_t product = ka->product;
+
+	if (multiplicand + 15 * (BASE - 1) > multiplicand_max)
+		goto out;
+
+	// Lane k is lane k - 1 plus one step of kernel_scalar.
+	fang_t e0 = ka->e0;
+	fang_t e1 = ka->e1;
+	fang_t de0 = ka->de0;
+	fang_t de1 = ka->de1;
+	fang_t de2 = ka->de2;
+	uint32_t lane[6][16];
+	for (int k = 0; k < 16; k++) {
+		lane[0][k] = e0;
+		lane[1][k] = e1;
+		lane[2][k] = de0;
+		lane[3][k] = de1;
+		lane[4][k] = de2;
+		lane[5][k] = multiplicand + k * (BASE - 1);
+		e0 += BASE - 1;
+		if (e0 >= power_a) {
+			e0 -= power_a;
+			e1 += 1;
+		}
+		de0 += ka->step0;
+		if (de0 >= power_a) {
+			de0 -= power_a;
+			de1 += 1;
+		}
+		de1 += ka->step1;
+		if (de1 >= power_a) {
+			de1 -= power_a;
+			de2 += 1;
+		}
+	}
+	__m512i v_e0 = _mm512_loadu_si512(lane[0]);
+	__m512i v_e1 = _mm512_loadu_si512(lane[1]);
+	__m512i v_de0 = _mm512_loadu_si512(lane[2]);
+	__m512i v_de1 = _mm512_loadu_si512(lane[3]);
+	__m512i v_de2 = _mm512_loadu_si512(lane[4]);
+	__m512i v_multiplicand = _mm512_loadu_si512(lane[5]);
+
+	const fang_t hex_m = 16 * (BASE - 1);
+	const vamp_t hex_p = 16 * product_iterator;
+	const __m512i inc_m = _mm512_set1_epi32(hex_m);
+	const __m512i inc_e0 = _mm512_set1_epi32(hex_m % power_a);
+	const __m512i inc_e1 = _mm512_set1_epi32(hex_m / power_a);
+	const __m512i inc_de0 = _mm512_set1_epi32(hex_p % power_a);
+	const __m512i inc_de1 = _mm512_set1_epi32((hex_p / power_a) % power_a);
+	const __m512i inc_de2 = _mm512_set1_epi32((hex_p / power_a) / power_a);
+	const __m512i v_power_a = _mm512_set1_epi32(power_a);
+	const __m512i v_limit = _mm512_set1_epi32(power_a - 1);
+	const __m512i v_one = _mm512_set1_epi32(1);
+#if ELEMENT_BITS == 64
+	const __m512i v_digd = _mm512_set1_epi64(ka->digd);
+#else
+	const __m512i v_digd = _mm512_set1_epi32(ka->digd);
+#endif
+
+	for (; multiplicand + 15 * (BASE - 1) <= multiplicand_max; multiplicand += hex_m) {
+#if ELEMENT_BITS == 64
+		__mmask16 match = match8(dig, v_digd,
+			_mm512_castsi512_si256(v_e0),
+			_mm512_castsi512_si256(v_e1),
+			_mm512_castsi512_si256(v_de0),
+			_mm512_castsi512_si256(v_de1),
+			_mm512_castsi512_si256(v_de2));
+		match |= (__mmask16)match8(dig, v_digd,
+			_mm512_extracti64x4_epi64(v_e0, 1),
+			_mm512_extracti64x4_epi64(v_e1, 1),
+			_mm512_extracti64x4_epi64(v_de0, 1),
+			_mm512_extracti64x4_epi64(v_de1, 1),
+			_mm512_extracti64x4_epi64(v_de2, 1)) << 8;
+#else
+		__m512i a = _mm512_add_epi32(v_digd, _mm512_i32gather_epi32(v_e0, dig, 4));
+		a = _mm512_add_epi32(a, _mm512_i32gather_epi32(v_e1, dig, 4));
+		__m512i b = _mm512_i32gather_epi32(v_de0, dig, 4);
+		b = _mm512_add_epi32(b, _mm512_i32gather_epi32(v_de1, dig, 4));
+		b = _mm512_add_epi32(b, _mm512_i32gather_epi32(v_de2, dig, 4));
+		__mmask16 match = _mm512_cmpeq_epi32_mask(a, b);
+#endif
+		if (match != 0) {
+			uint32_t hit[16];
+			_mm512_mask_compressstoreu_epi32(hit, match, v_multiplicand);
+			for (int i = 0; i < __builtin_popcount(match); i++) {
+				fang_t hit_multiplicand = hit[i];
+				vamp_t hit_product = ka->multiplier;
+				hit_product *= hit_multiplicand;
+				if (ka->mult_zero || notrailingzero(hit_multiplicand))
+					kernel_hit(args, ll, hit_product, ka->multiplier, hit_multiplicand);
+			}
+		}
+		product += hex_p;
+		v_multiplicand = _mm512_add_epi32(v_multiplicand, inc_m);
+
+		__mmask16 carry;
+		v_e0 = _mm512_add_epi32(v_e0, inc_e0);
+		carry = _mm512_cmpgt_epu32_mask(v_e0, v_limit);
+		v_e0 = _mm512_mask_sub_epi32(v_e0, carry, v_e0, v_power_a);
+		v_e1 = _mm512_add_epi32(v_e1, inc_e1);
+		v_e1 = _mm512_mask_add_epi32(v_e1, carry, v_e1, v_one);
+
+		v_de0 = _mm512_add_epi32(v_de0, inc_de0);
+		carry = _mm512_cmpgt_epu32_mask(v_de0, v_limit);
+		v_de0 = _mm512_mask_sub_epi32(v_de0, carry, v_de0, v_power_a);
+		v_de1 = _mm512_add_epi32(v_de1, inc_de1);
+		v_de1 = _mm512_mask_add_epi32(v_de1, carry, v_de1, v_one);
+		carry = _mm512_cmpgt_epu32_mask(v_de1, v_limit);
+		v_de1 = _mm512_mask_sub_epi32(v_de1, carry, v_de1, v_power_a);
+		v_de2 = _mm512_add_epi32(v_de2, inc_de2);
+		v_de2 = _mm512_mask_add_epi32(v_de2, carry, v_de2, v_one);
+	}
+
+	// Lane 0 holds the first multiplicand that hasn't been checked.
+	ka->multiplicand = multiplicand;
+	ka->product = product;
+	ka->e0 = (uint32_t)_mm_cvtsi128_si32(_mm512_castsi512_si128(v_e0));
+	ka->e1 = (uint32_t)_mm_cvtsi128_si32(_mm512_castsi512_si128(v_e1));
+	ka->de0 = (uint32_t)_mm_cvtsi128_si32(_mm512_castsi512_si128(v_de0));
+	ka->de1 = (uint32_t)_mm_cvtsi128_si32(_mm512_castsi512_si128(v_de1));
+	ka->de2 = (uint32_t)_mm_cvtsi128_si32(_mm512_castsi512_si128(v_de2));
+out:
+	kernel_scalar(ka, args, ll);
+}
+#endif /* CACHE && KERNEL_X86 && !USE_PDEP */
@@ -15,116 +15,71 @@
 #include "array.h"
 #include "cache.h"
 #include "vargs.h"
+#include "kernel.h"
 
 #if SANITY_CHECK
 #include <assert.h>
 #endif
 
-#if USE_PDEP
-#include <immintrin.h>
-#endif
+#define MULT_SKIP 4
+#define SPLIT_POWERS 8 // See kargs_split
+#define SPLIT_POWER(a) ((fang_t)((a) > 0 ? BASE : 1) * ((a) > 1 ? BASE : 1) * \
+	((a) > 2 ? BASE : 1) * ((a) > 3 ? BASE : 1) * ((a) > 4 ? BASE : 1) * \
+	((a) > 5 ? BASE : 1) * ((a) > 6 ? BASE : 1) * ((a) > 7 ? BASE : 1))
 
-#if USE_PDEP
-static uint64_t get_pdep_mask()
-{
-	uint64_t single_element_mask = 1;
-	single_element_mask <<= (ACTIVE_BITS - 1) / (BASE - 1);
-	single_element_mask -= 1;
-	single_element_mask <<= 1;
-	single_element_mask += 1;
-
-	uint64_t ret = single_element_mask;
-	for (int i = 1; i < BASE - 1; i++) {
-		ret <<= (COMPARISON_BITS / (BASE - 1));
-		ret += single_element_mask;
-	}
-	return ret;
-}
-#endif
+/*
+ * mult_dec:
+ *
+ * Moves from multiplier x to x - 1, while keeping:
+ * 	q = div_roof(min, x)
+ * 	rem = q * x - min
+ *
+ * As the multiplier goes down by 1, q * x goes down by q. Whenever that
+ * drops below min, q increases. No divisions are required.
+ */
 
-static bool notrailingzero(fang_t x)
+static inline void mult_dec(fang_t *x, vamp_t *q, vamp_t *rem)
 {
-	return ((x % BASE) != 0);
-}
+	*x -= 1;
+	if (*x == 0)
+		return;
 
-static fang_t sqrtv_floor(vamp_t x) // vamp_t sqrt to fang_t.
-{
-	vamp_t x2 = x / 2;
-	vamp_t root = x2;
-	if (root > 0) {
-		vamp_t tmp = (root + x / root) / 2;
-		while (tmp < root) {
-			root = tmp;
-			tmp = (root + x / root) / 2;
-		}
-		return root;
+	vamp_t need = *q;
+	while (*rem < need) {
+		*rem += *x;
+		*q += 1;
 	}
-	return x;
-}
-
-static fang_t sqrtv_roof(vamp_t x)
-{
-	if (x == 0)
-		return 0;
-
-	fang_t root = sqrtv_floor(x);
-	if (root == FANG_MAX)
-		return root;
-
-	return (x / root);
+	*rem -= need;
 }
 
 /*
- * disqualify_mult:
+ * set_congruence:
+ *
+ * The multiplier, multiplicand and product must be congruent modulo BASE - 1:
+ * 	(x + y) % (BASE - 1) == (x * y) % (BASE - 1)
  *
- * Disqualify ineligible values before congruence_check.
- * Currently suppoted numerical bases: 2~10.
+ * congruence[a][b] is the smallest d, such that a multiplier x with
+ * x % (BASE - 1) == a and a multiplicand y with y % (BASE - 1) == b + d
+ * are congruent, or BASE - 1 if there is none. In that case no multiplicand
+ * is congruent with the multiplier, and we can disqualify it.
  */
 
-static bool disqualify_mult(vamp_t x)
+static void set_congruence(digit_t congruence[BASE - 1][BASE - 1])
 {
-	bool ret = false;
-	switch (BASE) {
-		case 2:
-			ret = false;
-			break;
-		case 7:	{
-			int tmp = x % (BASE - 1);
-			ret = (tmp == 1 || tmp == 3 || tmp == 4 || tmp == 5);
-			break;
+	for (digit_t a = 0; a < BASE - 1; a++) {
+		for (digit_t b = 0; b < BASE - 1; b++) {
+			digit_t d = 0;
+			for (; d < BASE - 1; d++) {
+				digit_t y = (b + d) % (BASE - 1);
+				if ((a + y) % (BASE - 1) == (a * y) % (BASE - 1))
+					break;
+			}
+			congruence[a][b] = d;
 		}
-		case 10:
-			ret = (x % 3 == 1);
-			break;
-		default:
-			/*
-			 * A represents the last bit of multiplier
-			 * B represents the last bit of multiplicand
-			 *
-			 * A B  A+B  A*B  Match
-			 * 0 0   0    0   true
-			 * 0 1   1    0   false
-			 * 1 0   1    0   false
-			 * 1 1 (1)0   1   false
-			 *
-			 * If BASE-1 is a power of two, we can safely disqualify
-			 * the cases where A is 1.
-			 */
-			if (((BASE - 1) & (BASE - 2)) == 0)
-				ret = x % 2;
-			else
-				ret = (x % (BASE - 1) == 1);
 	}
-	return ret;
 }
 
-// Modulo base-1 lack of congruence
-static bool congruence_check(vamp_t x, vamp_t y)
-{
-	return ((x + y) % (BASE - 1) != (x * y) % (BASE - 1));
-}
-
-void vargs_new(struct vargs **ptr, struct cache *digptr)
+void vargs_new(struct vargs **ptr, struct cache *digptr, const struct kernel *kernel, bool keep_raw)
 {
 #if SANITY_CHECK
 	assert(ptr != NULL);
@@ -136,8 +91,15 @@ void vargs_new(struct vargs **ptr, struct cache *digptr)
 		abort();
 
 	new->digptr = digptr;
+	new->kernel = kernel;
 	new->local_count = 0;
 	new->result = NULL;
+	new->keep_raw = keep_raw;
+	new->raw = NULL;
+	new->arena = NULL;
+	arena_new(&(new->arena));
+	new->hits = 0;
+	set_congruence(new->congruence);
 	*ptr = new;
 }
 
@@ -147,6 +109,8 @@ void vargs_free(struct vargs *args)
 		return;
 
 	array_free(args->result);
+	llnode_free(args->raw);
+	arena_free(args->arena);
 	free(args);
 }
 
@@ -155,28 +119,116 @@ void vargs_reset(struct vargs *args)
 	args->local_count = 0;
 	array_free(args->result);
 	args->result = NULL;
+	llnode_free(args->raw);
+	args->raw = NULL;
 }
 
-void vampire(vamp_t min, vamp_t max, struct vargs *args, fang_t fmax)
+#if CACHE
+/*
+ * kargs_split:
+ *
+ * Splits the multiplicand & the product of k in parts of power_a, see
+ * cache_new. It's inlined in vampire() with power_a = BASE^1 ~
+ * BASE^SPLIT_POWERS as constants, so the divisions become multiplications.
+ * With the default MAX_TASK_SIZE most multipliers only have a few dozen
+ * multiplicands in a task, and the divisions add up.
+ */
+
+static inline __attribute__((always_inline)) void kargs_split(
+	struct kargs *k,
+	fang_t multiplicand,
+	vamp_t product,
+	fang_t power_a,
+	length_t parts)
+{
+	k->e0 = multiplicand % power_a;
+	k->e1 = multiplicand / power_a;
+
+	k->de0 = product % power_a;
+	k->de1 = (product / power_a) % power_a;
+	k->de2 = (product / power_a) / power_a;
+
+	if (parts == 4) {
+		k->e2 = k->e1 / power_a;
+		k->e1 %= power_a;
+		k->de3 = k->de2 / power_a;
+		k->de2 %= power_a;
+	}
+}
+#endif /* CACHE */
+
+void vampire(vamp_t min, vamp_t max, struct vargs *args, fang_t fmin, fang_t fmax)
 {
 	struct llnode *ll = NULL;
 	fang_t min_sqrt = sqrtv_roof(min);
+	if (min_sqrt < fmin)
+		min_sqrt = fmin;
 	fang_t max_sqrt = sqrtv_floor(max);
+	const struct kernel *kernel = args->kernel;
+	struct kargs ka;
+
+	length_t parts = 3;
+	if (kernel->cache)
+		parts = cache_parts(args->digptr, max);
+	const length_t part_a = partition(length(max), parts);
+	const fang_t power_a = pow_v(part_a);
+
+	/*
+	 * fmax comes from the band that taskboard_set() split into tasks. If the
+	 * fangs of the band fit in 32 bits, we can use the 32-bit lanes of the
+	 * kernel, if it has them. Bands with the product in 4 parts always use
+	 * run4.
+	 */
+	void (*run)(struct kargs *ka, struct vargs *args, struct llnode **ll) = kernel->run;
+	if (parts == 4)
+		run = kernel->run4;
+	else if (kernel->run32 != NULL && fmax <= UINT32_MAX && power_a <= KERNEL32_POWER_A)
+		run = kernel->run32;
 
 #if CACHE
-	fang_t power_a = pow_v(partition3(length(max)));
-	digits_t *dig = args->digptr->dig;
-#if USE_PDEP
-	const uint64_t pdep_mask = get_pdep_mask();
-#endif
+	if (kernel->cache) {
+		ka.dig = args->digptr->dig;
+		ka.pack = args->digptr->pack;
+		ka.lut = args->digptr->lut;
+		ka.power_a = power_a;
+	}
 #endif
 
-	for (fang_t multiplier = fmax; multiplier >= min_sqrt && multiplier > 0; multiplier--) {
-		if (disqualify_mult(multiplier))
+	/*
+	 * The multiplier has a product in [min, max] if and only if
+	 * q * multiplier <= max, or rem <= max - min.
+	 *
+	 * In narrow intervals most multipliers don't, especially the ones
+	 * closer to fmax. Instead of two divisions per multiplier, we test
+	 * them with mult_dec. When a multiplier fails the test by more than
+	 * a few q, we skip all the multipliers that would fail it with the
+	 * same q, at the cost of one division.
+	 *
+	 * The unsigned arithmetic may wrap around when min is close to
+	 * VAMP_MAX, but rem is always correct, since rem < multiplier.
+	 */
+	const vamp_t width = max - min;
+	vamp_t q = 0;
+	vamp_t rem = 0;
+	if (fmax > 0) {
+		q = div_roof(min, fmax);
+		rem = q * fmax - min;
+	}
+
+	for (fang_t multiplier = fmax; multiplier >= min_sqrt && multiplier > 0; mult_dec(&multiplier, &q, &rem)) {
+		if (rem > width) {
+			if (rem - width >= MULT_SKIP * q) {
+				vamp_t skip = (rem - width) / q - 1; // The last step is mult_dec
+				multiplier -= skip;
+				rem -= skip * q;
+			}
+			continue;
+		}
+		digit_t *congruence = args->congruence[multiplier % (BASE - 1)];
+		if (congruence[0] == BASE - 1)
 			continue;
 
-		fang_t multiplicand = div_roof(min, multiplier); // fmin * fmax <= min - BASE^n
-		bool mult_zero = notrailingzero(multiplier);
+		fang_t multiplicand = q; // fmin * fmax <= min - BASE^n
 
 		fang_t multiplicand_max;
 		if (multiplier > max_sqrt)
@@ -185,8 +237,7 @@ void vampire(vamp_t min, vamp_t max, struct vargs *args, fang_t fmax)
 			multiplicand_max = multiplier;
 			// multiplicand <= multiplier: 5267275776 = 72576 * 72576.
 
-		while (multiplicand <= multiplicand_max && congruence_check(multiplier, multiplicand))
-			multiplicand++;
+		multiplicand += congruence[multiplicand % (BASE - 1)];
 
 		if (multiplicand <= multiplicand_max) {
 			/*
@@ -197,146 +248,93 @@ void vampire(vamp_t min, vamp_t max, struct vargs *args, fang_t fmax)
 			vamp_t product = multiplier;
 			product *= multiplicand; // avoid overflow
 
-#if CACHE
-			/*
-			 * We could just allocate the entire dig[] array, and then do:
-			 *
-			 * 	for (; multiplicand <= multiplicand_max; multiplicand += BASE - 1) {
-			 * 		if (dig[multiplier] + dig[multiplicand] == dig[product]) {
-			 * 			...
-			 * 		}
-			 * 		product += product_iterator;
-			 *		multiplicand += BASE-1;
-			 *	}
-			 *
-			 * This would work just fine.
-			 * The only problem is that the array would be way too
-			 * big to fit in most l3 caches and we would waste a
-			 * majority of time loading data from memory.
-			 *
-			 * If we 'partition' the numbers (123 -> 12, 3), we can
-			 * make the array much smaller.
-			 *
-			 * Of course, 'partitioning' requires some computation,
-			 * but we are already waiting for memory load
-			 * operations, and we might as well put the wasted
-			 * cycles to good use.
-			 *
-			 * I chose to 'partition' like this:
-			 * 	product:          de0,   de1,   de2
-			 * 	product iterator: step0, step1, step2
-			 *
-			 * 	multiplicand: e0, e1
-			 * Because it performs the best on all of my cpus.
-			 */
-
-			/*
-			 * We can improve the runtime even further by removing step2.
-			 * If step2 is always 0, we don't need it.
-			 *
-			 * step2 = (product_iterator / power_a) / power_a
-			 *
-			 * step2 has 0 digits, product_iterator has n+1, and we are going to solve for power_a:
-			 *
-			 * 0 >= (n+1 - x) - x
-			 * x >= n+1 - x
-			 */
-
-			fang_t step0 = product_iterator % power_a;
-			fang_t step1 = product_iterator / power_a;
+			ka.multiplier = multiplier;
+			ka.multiplicand = multiplicand;
+			ka.multiplicand_max = multiplicand_max;
+			ka.product = product;
+			ka.product_iterator = product_iterator;
+			ka.mult_zero = notrailingzero(multiplier);
 
-			/*
-			 * digd = dig[multiplier];
-			 * Each digd is calculated and accessed only once, we don't need to store them in memory.
-			 * We can calculate digd on the spot and make the dig array 10 times smaller.
-			 */
-
-			digits_t digd = set_dig(multiplier);
-
-			fang_t e0 = multiplicand % power_a;
-			fang_t e1 = multiplicand / power_a;
-
-			fang_t de0 = product % power_a;
-			fang_t de1 = (product / power_a) % power_a;
-			fang_t de2 = (product / power_a) / power_a;
-
-			for (; multiplicand <= multiplicand_max; multiplicand += BASE - 1) {
-#if USE_PDEP
-				uint64_t a = 0;
-				a += _pdep_u64(digd, pdep_mask);
-				a += _pdep_u64(dig[e0], pdep_mask);
-				a += _pdep_u64(dig[e1], pdep_mask);
-				uint64_t b = 0;
-				b += _pdep_u64(dig[de0], pdep_mask);
-				b += _pdep_u64(dig[de1], pdep_mask);
-				b += _pdep_u64(dig[de2], pdep_mask);
-				if (a == b)
-#else
-				if (digd + dig[e0] + dig[e1] == dig[de0] + dig[de1] + dig[de2])
-#endif
-					if (mult_zero || notrailingzero(multiplicand)) {
-						vargs_iterate_local_count(args);
-						vargs_print_results(product, multiplier, multiplicand);
-						llnode_add(&(ll), product);
-					}
-				product += product_iterator;
-				e0 += BASE - 1;
-				if (e0 >= power_a) {
-					e0 -= power_a;
-					e1 += 1;
-				}
-				de0 += step0;
-				if (de0 >= power_a) {
-					de0 -= power_a;
-					de1 += 1;
-				}
-				de1 += step1;
-				if (de1 >= power_a) {
-					de1 -= power_a;
-					de2 += 1;
-				}
-			}
-
-#else /* CACHE */
-
-			length_t mult_array[BASE] = {0};
-			for (fang_t i = multiplier; i > 0; i /= BASE)
-				mult_array[i % BASE] += 1;
-
-			for (; multiplicand <= multiplicand_max; multiplicand += BASE - 1) {
-				uint16_t product_array[BASE] = {0};
-				for (vamp_t p = product; p > 0; p /= BASE)
-					product_array[p % BASE] += 1;
-
-				for (digit_t i = 0; i < BASE; i++)
-					if (product_array[i] < mult_array[i])
-						goto vampire_exit;
-
-				digit_t temp;
-				for (fang_t m = multiplicand; m > 0; m /= BASE) {
-					temp = m % BASE;
-					if (product_array[temp] == 0)
-						goto vampire_exit;
-					else
-						product_array[temp]--;
-				}
-				for (digit_t i = 0; i < (BASE - 1); i++)
-					if (product_array[i] != mult_array[i])
-						goto vampire_exit;
-
-				if (mult_zero || notrailingzero(multiplicand)) {
-					vargs_iterate_local_count(args);
-					vargs_print_results(product, multiplier, multiplicand);
-					llnode_add(&(ll), product);
+#if CACHE
+			if (kernel->cache) {
+				/*
+				 * We could just allocate the entire dig[] array, and then do:
+				 *
+				 * 	for (; multiplicand <= multiplicand_max; multiplicand += BASE - 1) {
+				 * 		if (dig[multiplier] + dig[multiplicand] == dig[product]) {
+				 * 			...
+				 * 		}
+				 * 		product += product_iterator;
+				 *		multiplicand += BASE-1;
+				 *	}
+				 *
+				 * This would work just fine.
+				 * The only problem is that the array would be way too
+				 * big to fit in most l3 caches and we would waste a
+				 * majority of time loading data from memory.
+				 *
+				 * If we 'partition' the numbers (123 -> 12, 3), we can
+				 * make the array much smaller.
+				 *
+				 * Of course, 'partitioning' requires some computation,
+				 * but we are already waiting for memory load
+				 * operations, and we might as well put the wasted
+				 * cycles to good use.
+				 *
+				 * I chose to 'partition' like this:
+				 * 	product:          de0,   de1,   de2
+				 * 	product iterator: step0, step1, step2
+				 *
+				 * 	multiplicand: e0, e1
+				 * Because it performs the best on all of my cpus.
+				 */
+
+				/*
+				 * We can improve the runtime even further by removing step2.
+				 * If step2 is always 0, we don't need it.
+				 *
+				 * step2 = (product_iterator / power_a) / power_a
+				 *
+				 * step2 has 0 digits, product_iterator has n+1, and we are going to solve for power_a:
+				 *
+				 * 0 >= (n+1 - x) - x
+				 * x >= n+1 - x
+				 *
+				 * With the product in 4 parts (see cache_new) it's step3
+				 * that we remove, and power_a can be smaller.
+				 */
+
+				ka.step0 = product_iterator % power_a;
+				ka.step1 = (product_iterator / power_a) % power_a;
+				ka.step2 = (product_iterator / power_a) / power_a;
+
+				/*
+				 * digd = dig[multiplier];
+				 * Each digd is calculated and accessed only once, we don't need to store them in memory.
+				 * We can calculate digd on the spot and make the dig array 10 times smaller.
+				 */
+
+				ka.digd = set_dig(multiplier);
+
+#define SPLIT(a) case a: kargs_split(&ka, multiplicand, product, SPLIT_POWER(a), parts); break;
+				switch (part_a) {
+					SPLIT(1) SPLIT(2) SPLIT(3) SPLIT(4)
+					SPLIT(5) SPLIT(6) SPLIT(7) SPLIT(SPLIT_POWERS)
+					default:
+						kargs_split(&ka, multiplicand, product, power_a, parts);
+						break;
 				}
-vampire_exit:
-				product += product_iterator;
+#undef SPLIT
 			}
-
 #endif /* CACHE */
+			run(&ka, args, &ll);
 		}
 	}
-	array_new(&(args->result), ll, &(args->local_count));
-	llnode_free(ll);
+	if (args->keep_raw) {
+		args->raw = ll;
+		return;
+	}
+	array_new(&(args->result), ll, &(args->local_count), args->arena);
+	arena_recycle(args->arena, ll);
 	return;
 }
@@ -6,25 +6,42 @@
 #ifndef HELSING_VARGS_H
 #define HELSING_VARGS_H
 
+#include <stdbool.h>
+
 #include "configuration_adv.h"
 #include "cache.h"
 #include "array.h"
+#include "llnode.h"
 
 #ifdef DUMP_RESULTS
 #include <stdio.h>
+#include "helper.h"
 #endif
 
+#define VARGS_HITS 256 // The size of the hit buffer, see kernel_avx512.
+
+struct kernel;
+
 struct vargs /* Vampire arguments */
 {
 	struct cache *digptr;
+	const struct kernel *kernel;
 	struct array *result;
 	vamp_t local_count;
+	bool keep_raw; // Leave the results unprocessed in raw, see taskboard_merge.
+	struct llnode *raw;
+	struct arena *arena;
+
+	digit_t congruence[BASE - 1][BASE - 1]; // See set_congruence.
+
+	fang_t hit_multiplicand[VARGS_HITS];
+	int hits;
 };
 
-void vargs_new(struct vargs **ptr, struct cache *digptr);
+void vargs_new(struct vargs **ptr, struct cache *digptr, const struct kernel *kernel, bool keep_raw);
 void vargs_free(struct vargs *args);
 void vargs_reset(struct vargs *args);
-void vampire(vamp_t min, vamp_t max, struct vargs *args, fang_t fmax);
+void vampire(vamp_t min, vamp_t max, struct vargs *args, fang_t fmin, fang_t fmax);
 
 #if defined COUNT_RESULTS || defined DUMP_RESULTS
 static inline void vargs_iterate_local_count(struct vargs *ptr)
@@ -44,8 +61,9 @@ static inline void vargs_print_results(
 	fang_t multiplier,
 	fang_t multiplicand)
 {
+	char product_str[VAMP_STR_SIZE];
 	flockfile(stdout);
-	printf("%llu = %lu x %lu\n", product, multiplier, multiplicand);
+	printf("%s = %lu x %lu\n", vtostr(product, product_str), multiplier, multiplicand);
 	funlockfile(stdout);
 }
 #else /* DUMP_RESULTS */